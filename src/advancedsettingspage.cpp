@@ -45,6 +45,7 @@ void AdvancedSettingsPage::setModel( FractalModel* model )
     connect( m_model, SIGNAL( generatorSettingsChanged() ), this, SLOT( generatorSettingsChanged() ) );
     connect( m_model, SIGNAL( viewSettingsChanged() ), this, SLOT( viewSettingsChanged() ) );
     connect( m_model, SIGNAL( viewModeChanged() ), this, SLOT( viewModeChanged() ) );
+    connect( m_model, SIGNAL( iterationStatisticsChanged() ), this, SLOT( iterationStatisticsChanged() ) );
 }
 
 void AdvancedSettingsPage::on_sliderDepth_valueChanged()
@@ -52,6 +53,18 @@ void AdvancedSettingsPage::on_sliderDepth_valueChanged()
     saveGenerator();
 }
 
+void AdvancedSettingsPage::on_checkAutoDepth_toggled()
+{
+    m_ui.sliderDepth->setEnabled( !m_ui.checkAutoDepth->isChecked() );
+    saveGenerator();
+}
+
+void AdvancedSettingsPage::on_checkProgressive_toggled()
+{
+    if ( !m_loading )
+        m_model->setProgressiveDepth( m_ui.checkProgressive->isChecked() );
+}
+
 void AdvancedSettingsPage::on_sliderDetail_valueChanged()
 {
     saveGenerator();
@@ -153,12 +166,22 @@ void AdvancedSettingsPage::viewModeChanged()
     m_ui.radioResVHigh->setEnabled( isMesh );
 }
 
+void AdvancedSettingsPage::iterationStatisticsChanged()
+{
+    int iterations = m_model->iterations();
+    m_ui.labelIterations->setText( iterations > 0 ? tr( "%1 iterations" ).arg( iterations ) : QString() );
+    m_ui.histogram->setHistogram( m_model->escapeHistogram(), iterations );
+}
+
 void AdvancedSettingsPage::loadGenerator()
 {
     m_loading = true;
 
     GeneratorSettings settings = m_model->generatorSettings();
     m_ui.sliderDepth->setScaledValue( settings.calculationDepth() );
+    m_ui.sliderDepth->setEnabled( !settings.automaticDepth() );
+    m_ui.checkAutoDepth->setChecked( settings.automaticDepth() );
+    m_ui.checkProgressive->setChecked( m_model->progressiveDepth() );
     m_ui.sliderDetail->setScaledValue( settings.detailThreshold() );
 
     m_loading = false;
@@ -171,6 +194,7 @@ void AdvancedSettingsPage::saveGenerator()
 
     GeneratorSettings settings;
     settings.setCalculationDepth( m_ui.sliderDepth->scaledValue() );
+    settings.setAutomaticDepth( m_ui.checkAutoDepth->isChecked() );
     settings.setDetailThreshold( m_ui.sliderDetail->scaledValue() );
     m_model->setGeneratorSettings( settings );
 }
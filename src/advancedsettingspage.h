@@ -37,6 +37,8 @@ public:
 
 private slots:
     void on_sliderDepth_valueChanged();
+    void on_checkAutoDepth_toggled();
+    void on_checkProgressive_toggled();
     void on_sliderDetail_valueChanged();
     void on_radioAANone_clicked();
     void on_radioAALow_clicked();
@@ -55,6 +57,7 @@ private slots:
     void generatorSettingsChanged();
     void viewSettingsChanged();
     void viewModeChanged();
+    void iterationStatisticsChanged();
 
 private:
     void loadGenerator();
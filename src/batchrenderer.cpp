@@ -0,0 +1,463 @@
+/**************************************************************************
+* This file is part of the Fraqtive program
+* Copyright (C) 2004-2012 Michał Męciński
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**************************************************************************/
+
+#include "batchrenderer.h"
+
+#include <QEventLoop>
+#include <QFileInfo>
+#include <QImageWriter>
+#include <QThread>
+#include <QTime>
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "fraqtiveapplication.h"
+#include "configurationdata.h"
+#include "datafunctions.h"
+#include "imagegenerator.h"
+#include "checkpoint.h"
+#include "rendercoordinator.h"
+#include "renderworker.h"
+#include "tiffwriter.h"
+
+BatchRenderer::BatchRenderer( QObject* parent ) : QObject( parent ),
+    m_resume( false ),
+    m_workerCount( 0 ),
+    m_multiSampling( 0 ),
+    m_adaptive( false ),
+    m_maximumProgress( 0 ),
+    m_reportedProgress( 0 )
+{
+}
+
+BatchRenderer::~BatchRenderer()
+{
+}
+
+bool BatchRenderer::isBatchMode( int argc, char** argv )
+{
+    for ( int i = 1; i < argc; i++ ) {
+        if ( !strcmp( argv[ i ], "--render" ) || !strcmp( argv[ i ], "--worker" ) )
+            return true;
+    }
+    return false;
+}
+
+int BatchRenderer::exec( const QStringList& arguments )
+{
+    if ( !parseArguments( arguments ) )
+        return 2;
+
+    if ( !m_serverName.isEmpty() ) {
+        RenderWorker worker( this );
+        return worker.exec( m_serverName );
+    }
+
+    return render() ? 0 : 1;
+}
+
+static bool parseNumbers( const QString& text, QChar separator, QVector<double>* numbers, int minimum, int maximum )
+{
+    QStringList parts = text.split( separator );
+    if ( parts.count() < minimum || parts.count() > maximum )
+        return false;
+
+    for ( int i = 0; i < parts.count(); i++ ) {
+        bool ok;
+        numbers->append( parts.at( i ).toDouble( &ok ) );
+        if ( !ok )
+            return false;
+    }
+
+    return true;
+}
+
+bool BatchRenderer::parseArguments( const QStringList& arguments )
+{
+    ConfigurationData* config = fraqtive()->configuration();
+
+    m_type.setIntegralExponent( 2 );
+
+    m_gradient = config->value( "Gradient", QVariant::fromValue( DataFunctions::defaultGradient() ) ).value<Gradient>();
+    m_backgroundColor = config->value( "Background", QColor( Qt::black ) ).value<QColor>();
+    m_colorMapping = config->value( "ColorMapping", QVariant::fromValue( DataFunctions::defaultColorMapping() ) ).value<ColorMapping>();
+
+    m_resolution = QSize( 1920, 1080 );
+    m_generatorSettings = DataFunctions::defaultGeneratorSettings();
+    m_viewSettings = DataFunctions::defaultViewSettings();
+
+    QString bookmark;
+    QString preset;
+    bool hasPosition = false;
+
+    for ( int i = 1; i < arguments.count(); i++ ) {
+        QString option = arguments.at( i );
+
+        if ( option == QLatin1String( "--adaptive" ) ) {
+            m_adaptive = true;
+            continue;
+        }
+        if ( option == QLatin1String( "--auto-depth" ) ) {
+            m_generatorSettings.setAutomaticDepth( true );
+            continue;
+        }
+        if ( option == QLatin1String( "--resume" ) ) {
+            m_resume = true;
+            continue;
+        }
+
+        if ( i + 1 >= arguments.count() ) {
+            printUsage();
+            return false;
+        }
+
+        QString value = arguments.at( ++i );
+        QVector<double> numbers;
+        bool ok = true;
+
+        if ( option == QLatin1String( "--render" ) ) {
+            m_fileName = value;
+        } else if ( option == QLatin1String( "--worker" ) ) {
+            m_serverName = value;
+        } else if ( option == QLatin1String( "--workers" ) ) {
+            m_workerCount = value.toInt( &ok );
+            ok = ok && m_workerCount >= 0;
+        } else if ( option == QLatin1String( "--bookmark" ) ) {
+            bookmark = value;
+        } else if ( option == QLatin1String( "--preset" ) ) {
+            preset = value;
+        } else if ( option == QLatin1String( "--type" ) ) {
+            if ( value == QLatin1String( "mandelbrot" ) )
+                m_type.setFractal( MandelbrotFractal );
+            else if ( value == QLatin1String( "julia" ) )
+                m_type.setFractal( JuliaFractal );
+            else
+                ok = false;
+        } else if ( option == QLatin1String( "--parameter" ) ) {
+            ok = parseNumbers( value, QLatin1Char( ',' ), &numbers, 2, 2 );
+            if ( ok )
+                m_type.setParameter( QPointF( numbers.at( 0 ), numbers.at( 1 ) ) );
+        } else if ( option == QLatin1String( "--exponent" ) ) {
+            double exponent = value.toDouble( &ok );
+            if ( ok && exponent == (int)exponent && exponent >= 2 ) {
+                m_type.setExponentType( IntegralExponent );
+                m_type.setIntegralExponent( (int)exponent );
+            } else if ( ok ) {
+                m_type.setExponentType( RealExponent );
+                m_type.setRealExponent( exponent );
+            }
+        } else if ( option == QLatin1String( "--variant" ) ) {
+            if ( value == QLatin1String( "normal" ) )
+                m_type.setVariant( GeneratorCore::NormalVariant );
+            else if ( value == QLatin1String( "conjugate" ) )
+                m_type.setVariant( GeneratorCore::ConjugateVariant );
+            else if ( value == QLatin1String( "absolute" ) )
+                m_type.setVariant( GeneratorCore::AbsoluteVariant );
+            else if ( value == QLatin1String( "absolute-im" ) )
+                m_type.setVariant( GeneratorCore::AbsoluteImVariant );
+            else
+                ok = false;
+        } else if ( option == QLatin1String( "--position" ) ) {
+            ok = parseNumbers( value, QLatin1Char( ',' ), &numbers, 3, 4 );
+            if ( ok ) {
+                m_position.setCenter( QPointF( numbers.at( 0 ), numbers.at( 1 ) ) );
+                m_position.setZoomFactor( numbers.at( 2 ) );
+                m_position.setAngle( numbers.count() > 3 ? numbers.at( 3 ) : 0.0 );
+                hasPosition = true;
+            }
+        } else if ( option == QLatin1String( "--size" ) ) {
+            ok = parseNumbers( value, QLatin1Char( 'x' ), &numbers, 2, 2 );
+            if ( ok ) {
+                m_resolution = QSize( (int)numbers.at( 0 ), (int)numbers.at( 1 ) );
+                ok = m_resolution.width() > 0 && m_resolution.height() > 0;
+            }
+        } else if ( option == QLatin1String( "--depth" ) ) {
+            m_generatorSettings.setCalculationDepth( value.toDouble( &ok ) );
+            m_generatorSettings.setAutomaticDepth( false );
+        } else if ( option == QLatin1String( "--detail" ) ) {
+            m_generatorSettings.setDetailThreshold( value.toDouble( &ok ) );
+        } else if ( option == QLatin1String( "--multisampling" ) ) {
+            m_multiSampling = value.toInt( &ok );
+            ok = ok && m_multiSampling >= 0 && m_multiSampling <= 3;
+        } else if ( option == QLatin1String( "--antialiasing" ) ) {
+            if ( value == QLatin1String( "none" ) )
+                m_viewSettings.setAntiAliasing( NoAntiAliasing );
+            else if ( value == QLatin1String( "low" ) )
+                m_viewSettings.setAntiAliasing( LowAntiAliasing );
+            else if ( value == QLatin1String( "medium" ) )
+                m_viewSettings.setAntiAliasing( MediumAntiAliasing );
+            else if ( value == QLatin1String( "high" ) )
+                m_viewSettings.setAntiAliasing( HighAntiAliasing );
+            else
+                ok = false;
+        } else {
+            printError( QString( "unknown option %1" ).arg( option ) );
+            printUsage();
+            return false;
+        }
+
+        if ( !ok ) {
+            printError( QString( "invalid value of %1: %2" ).arg( option, value ) );
+            return false;
+        }
+    }
+
+    // workers receive all settings from the coordinator
+    if ( !m_serverName.isEmpty() )
+        return true;
+
+    if ( m_fileName.isEmpty() ) {
+        printUsage();
+        return false;
+    }
+
+    // a bookmark replaces the type and position given explicitly
+    if ( !bookmark.isEmpty() ) {
+        const BookmarkMap* bookmarks = config->bookmarks();
+        if ( !bookmarks->contains( bookmark ) ) {
+            printError( QString( "bookmark %1 does not exist" ).arg( bookmark ) );
+            return false;
+        }
+
+        m_type = bookmarks->value( bookmark ).fractalType();
+        m_position = bookmarks->value( bookmark ).position();
+    } else if ( !hasPosition ) {
+        m_position = DataFunctions::defaultPosition( m_type );
+    }
+
+    if ( !preset.isEmpty() ) {
+        const PresetMap* presets = config->userPresets();
+        if ( !presets->contains( preset ) )
+            presets = config->defaultPresets();
+
+        if ( !presets->contains( preset ) ) {
+            printError( QString( "preset %1 does not exist" ).arg( preset ) );
+            return false;
+        }
+
+        m_gradient = presets->value( preset ).gradient();
+        m_backgroundColor = presets->value( preset ).backgroundColor();
+        m_colorMapping = presets->value( preset ).colorMapping();
+    }
+
+    return true;
+}
+
+bool BatchRenderer::render()
+{
+    QByteArray format = QFileInfo( m_fileName ).suffix().toLower().toLatin1();
+    if ( format == "tif" )
+        format = "tiff";
+    else if ( format == "jpg" )
+        format = "jpeg";
+
+    // TIFF images are written while they are generated, so their size is not limited by memory
+    bool streaming = ( format == "tiff" );
+
+    if ( !streaming && !QImageWriter::supportedImageFormats().contains( format ) ) {
+        printError( QString( "unsupported image format %1" ).arg( QString::fromLatin1( format ) ) );
+        return false;
+    }
+
+    if ( m_workerCount > 0 )
+        return renderDistributed( format, streaming );
+
+    // the writer and checkpoint must outlive the generator which is still using them
+    Checkpoint checkpoint( m_fileName );
+    TiffWriter tiffWriter( m_fileName );
+
+    ImageGenerator generator( this );
+    generator.setResolution( m_resolution );
+    generator.setMultiSampling( m_multiSampling );
+    generator.setAdaptiveSampling( m_adaptive );
+    generator.setParameters( m_type, m_position );
+    generator.setColorSettings( m_gradient, m_backgroundColor, m_colorMapping );
+    generator.setGeneratorSettings( m_generatorSettings );
+    generator.setViewSettings( m_viewSettings );
+
+    if ( streaming )
+        generator.setCheckpoint( &checkpoint );
+
+    QEventLoop eventLoop;
+
+    connect( &generator, SIGNAL( progressChanged( int ) ), this, SLOT( generatorProgress( int ) ), Qt::QueuedConnection );
+    connect( &generator, SIGNAL( completed() ), &eventLoop, SLOT( quit() ), Qt::QueuedConnection );
+
+    QTime time;
+    time.start();
+
+    if ( streaming ) {
+        if ( !generator.startStreaming( &tiffWriter, m_resume ) ) {
+            printError( QString( "cannot write %1" ).arg( m_fileName ) );
+            return false;
+        }
+    } else if ( !generator.start() ) {
+        printError( "not enough memory to generate image" );
+        return false;
+    }
+
+    m_maximumProgress = generator.maximumProgress();
+    m_reportedProgress = 0;
+
+    eventLoop.exec();
+
+    int calculated = time.elapsed();
+
+    if ( streaming ) {
+        if ( !tiffWriter.close() ) {
+            printError( QString( "cannot write %1" ).arg( m_fileName ) );
+            return false;
+        }
+
+        checkpoint.remove();
+    } else {
+        QImageWriter writer( m_fileName, format );
+
+        if ( !writer.write( generator.takeImage() ) ) {
+            printError( QString( "cannot write %1" ).arg( m_fileName ) );
+            return false;
+        }
+    }
+
+    int total = time.elapsed();
+
+    fprintf( stdout, "%dx%d image rendered in %.3f s, written in %.3f s (%d threads)\n", m_resolution.width(), m_resolution.height(),
+        calculated / 1000.0, ( total - calculated ) / 1000.0, QThread::idealThreadCount() );
+
+    return true;
+}
+
+bool BatchRenderer::renderDistributed( const QByteArray& format, bool streaming )
+{
+    if ( m_resolution.width() > TileProtocol::MaximumTilePixels ) {
+        printError( "the image is too wide to be rendered by worker processes" );
+        return false;
+    }
+
+    TiffWriter tiffWriter( m_fileName );
+
+    TileProtocol::RenderSettings settings;
+    settings.m_type = m_type;
+    settings.m_position = m_position;
+    settings.m_resolution = m_resolution;
+    settings.m_multiSampling = m_multiSampling;
+    settings.m_adaptive = m_adaptive;
+    settings.m_gradient = m_gradient;
+    settings.m_backgroundColor = m_backgroundColor;
+    settings.m_colorMapping = m_colorMapping;
+    settings.m_generatorSettings = m_generatorSettings;
+    settings.m_viewSettings = m_viewSettings;
+
+    // automatic depth is estimated once instead of in every tile
+    if ( settings.m_generatorSettings.automaticDepth() ) {
+        int iterations = (int)( pow( 10.0, m_generatorSettings.calculationDepth() ) * qMax( 1.0, 1.45 + m_position.zoomFactor() ) );
+        iterations = DataFunctions::estimateIterations( m_type, m_position, m_resolution * ( 1 << ( m_adaptive ? 0 : m_multiSampling ) ), iterations, NULL );
+
+        settings.m_generatorSettings.setCalculationDepth( log10( ( iterations + 0.5 ) / qMax( 1.0, 1.45 + m_position.zoomFactor() ) ) );
+        settings.m_generatorSettings.setAutomaticDepth( false );
+    }
+
+    RenderCoordinator coordinator( this );
+    coordinator.setSettings( settings );
+    coordinator.setWorkerCount( m_workerCount );
+
+    QEventLoop eventLoop;
+
+    connect( &coordinator, SIGNAL( progressChanged( int ) ), this, SLOT( generatorProgress( int ) ) );
+    connect( &coordinator, SIGNAL( completed() ), &eventLoop, SLOT( quit() ), Qt::QueuedConnection );
+
+    QTime time;
+    time.start();
+
+    if ( streaming ? !coordinator.startStreaming( &tiffWriter ) : !coordinator.start() ) {
+        printError( "cannot start worker processes" );
+        return false;
+    }
+
+    m_maximumProgress = coordinator.maximumProgress();
+    m_reportedProgress = 0;
+
+    eventLoop.exec();
+
+    int calculated = time.elapsed();
+
+    if ( coordinator.hasError() ) {
+        printError( "rendering failed" );
+        return false;
+    }
+
+    if ( streaming ) {
+        if ( !tiffWriter.close() ) {
+            printError( QString( "cannot write %1" ).arg( m_fileName ) );
+            return false;
+        }
+    } else {
+        QImageWriter writer( m_fileName, format );
+
+        if ( !writer.write( coordinator.takeImage() ) ) {
+            printError( QString( "cannot write %1" ).arg( m_fileName ) );
+            return false;
+        }
+    }
+
+    int total = time.elapsed();
+
+    fprintf( stdout, "%dx%d image rendered in %.3f s, written in %.3f s (%d worker processes)\n", m_resolution.width(), m_resolution.height(),
+        calculated / 1000.0, ( total - calculated ) / 1000.0, m_workerCount );
+
+    return true;
+}
+
+void BatchRenderer::generatorProgress( int value )
+{
+    // progress is reported in steps of ten percent
+    int percent = m_maximumProgress > 0 ? 100 * value / m_maximumProgress : 0;
+
+    if ( percent >= m_reportedProgress + 10 ) {
+        m_reportedProgress = percent - percent % 10;
+        fprintf( stderr, "%d%%\n", m_reportedProgress );
+    }
+}
+
+void BatchRenderer::printUsage() const
+{
+    fprintf( stderr, "usage: fraqtive --render FILE [options]\n"
+        "  --bookmark NAME          use the type and position of a bookmark\n"
+        "  --type mandelbrot|julia  fractal type (default mandelbrot)\n"
+        "  --parameter X,Y          parameter of the Julia fractal\n"
+        "  --exponent N             exponent (default 2)\n"
+        "  --variant normal|conjugate|absolute|absolute-im\n"
+        "  --position X,Y,ZOOM[,ANGLE]\n"
+        "  --preset NAME            use the colors of a preset\n"
+        "  --size WIDTHxHEIGHT      resolution (default 1920x1080)\n"
+        "  --depth DEPTH            calculation depth\n"
+        "  --auto-depth             estimate the calculation depth\n"
+        "  --detail THRESHOLD       detail threshold\n"
+        "  --multisampling 0-3      multi-sampling level\n"
+        "  --adaptive               multi-sample only the edges\n"
+        "  --antialiasing none|low|medium|high\n"
+        "  --resume                 continue an interrupted TIFF image\n"
+        "  --workers N              render tiles in N worker processes\n" );
+}
+
+void BatchRenderer::printError( const QString& message ) const
+{
+    fprintf( stderr, "fraqtive: %s\n", qPrintable( message ) );
+}
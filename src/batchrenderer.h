@@ -0,0 +1,77 @@
+/**************************************************************************
+* This file is part of the Fraqtive program
+* Copyright (C) 2004-2012 Michał Męciński
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**************************************************************************/
+
+#ifndef BATCHRENDERER_H
+#define BATCHRENDERER_H
+
+#include <QObject>
+#include <QStringList>
+#include <QColor>
+
+#include "datastructures.h"
+
+// renders a single image from the command line without creating any windows
+class BatchRenderer : public QObject
+{
+    Q_OBJECT
+public:
+    BatchRenderer( QObject* parent );
+    ~BatchRenderer();
+
+public:
+    static bool isBatchMode( int argc, char** argv );
+
+    int exec( const QStringList& arguments );
+
+private slots:
+    void generatorProgress( int value );
+
+private:
+    bool parseArguments( const QStringList& arguments );
+
+    bool render();
+    bool renderDistributed( const QByteArray& format, bool streaming );
+
+    void printUsage() const;
+    void printError( const QString& message ) const;
+
+private:
+    QString m_fileName;
+    bool m_resume;
+
+    int m_workerCount;
+    QString m_serverName;
+
+    FractalType m_type;
+    Position m_position;
+
+    Gradient m_gradient;
+    QColor m_backgroundColor;
+    ColorMapping m_colorMapping;
+
+    QSize m_resolution;
+    int m_multiSampling;
+    bool m_adaptive;
+    GeneratorSettings m_generatorSettings;
+    ViewSettings m_viewSettings;
+
+    int m_maximumProgress;
+    int m_reportedProgress;
+};
+
+#endif
@@ -36,7 +36,6 @@
 Q_DECLARE_METATYPE( QModelIndex )
 
 BookmarkModel::BookmarkModel( QObject* parent ) : QAbstractListModel( parent ),
-    m_gradientCache( NULL ),
     m_enabled( false ),
     m_activeJobs( 0 )
 {
@@ -51,8 +50,6 @@ BookmarkModel::~BookmarkModel()
 
     while ( m_activeJobs > 0 )
         m_allJobsDone.wait( &m_mutex );
-
-    delete[] m_gradientCache;
 }
 
 void BookmarkModel::setMap( BookmarkMap* map )
@@ -65,18 +62,13 @@ void BookmarkModel::setMap( BookmarkMap* map )
     m_queue = m_keys;
 }
 
-static const int GradientSize = 16384;
-
 void BookmarkModel::setColorSettings( const Gradient& gradient, const QColor& backgroundColor, const ColorMapping& mapping )
 {
     QMutexLocker locker( &m_mutex );
 
     cancelJobs();
 
-    if ( !m_gradientCache )
-        m_gradientCache = new QRgb[ GradientSize ];
-
-    DataFunctions::fillGradientCache( gradient, m_gradientCache, GradientSize );
+    m_gradientCache = DataFunctions::sharedGradientCache( gradient, DataFunctions::GradientSize );
 
     m_backgroundColor = backgroundColor;
     m_colorMapping = mapping;
@@ -209,6 +201,11 @@ void BookmarkModel::executeJob()
 
     Bookmark bookmark = m_map->value( name );
 
+    // the color settings can be replaced while the image is calculated
+    QVector<QRgb> gradientCache = m_gradientCache;
+    QColor backgroundColor = m_backgroundColor;
+    ColorMapping mapping = m_colorMapping;
+
     locker.unlock();
 
     const int imageSize = 48;
@@ -225,7 +222,7 @@ void BookmarkModel::executeJob()
 
     ViewSettings settings = DataFunctions::defaultViewSettings();
 
-    DataFunctions::ColorMapper mapper( m_gradientCache, GradientSize, m_backgroundColor.rgb(), m_colorMapping );
+    DataFunctions::ColorMapper mapper( gradientCache.constData(), gradientCache.count(), backgroundColor.rgb(), mapping );
     DataFunctions::drawImage( image, &data, image.rect(), mapper, settings.antiAliasing() );
 
     locker.relock();
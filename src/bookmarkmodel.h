@@ -23,6 +23,7 @@
 #include <QStringList>
 #include <QMutex>
 #include <QWaitCondition>
+#include <QVector>
 
 #include "abstractjobprovider.h"
 #include "datastructures.h"
@@ -67,7 +68,7 @@ private:
 private:
     BookmarkMap* m_map;
 
-    QRgb* m_gradientCache;
+    QVector<QRgb> m_gradientCache;
     QColor m_backgroundColor;
     ColorMapping m_colorMapping;
 
@@ -0,0 +1,121 @@
+/**************************************************************************
+* This file is part of the Fraqtive program
+* Copyright (C) 2004-2012 Michał Męciński
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**************************************************************************/
+
+#include "checkpoint.h"
+
+#include <QFile>
+#include <QDataStream>
+
+static const quint32 CheckpointMagic = 0x46514350;
+static const qint32 CheckpointVersion = 1;
+
+static const int CheckpointInterval = 10000;
+
+Checkpoint::Checkpoint( const QString& outputFileName ) :
+    m_fileName( outputFileName + QLatin1String( ".checkpoint" ) ),
+    m_progress( 0 )
+{
+    m_time.start();
+}
+
+Checkpoint::~Checkpoint()
+{
+}
+
+void Checkpoint::setParameters( const QByteArray& parameters )
+{
+    m_parameters = parameters;
+}
+
+bool Checkpoint::load()
+{
+    m_progress = 0;
+    m_state.clear();
+
+    QFile file( m_fileName );
+    if ( !file.open( QIODevice::ReadOnly ) )
+        return false;
+
+    QDataStream stream( &file );
+
+    quint32 magic;
+    qint32 version;
+    stream >> magic >> version;
+
+    if ( stream.status() != QDataStream::Ok || magic != CheckpointMagic || version != CheckpointVersion )
+        return false;
+
+    QByteArray parameters;
+    qint32 progress;
+    QByteArray state;
+    stream >> parameters >> progress >> state;
+
+    // the checkpoint is only valid for the same export
+    if ( stream.status() != QDataStream::Ok || parameters != m_parameters || progress <= 0 )
+        return false;
+
+    m_progress = progress;
+    m_state = state;
+
+    return true;
+}
+
+bool Checkpoint::isDue() const
+{
+    return m_time.elapsed() >= CheckpointInterval;
+}
+
+bool Checkpoint::save( int progress, const QByteArray& state /*= QByteArray()*/ )
+{
+    m_time.restart();
+
+    // the previous checkpoint is replaced only when the new one is completely written
+    QString tempName = m_fileName + QLatin1String( ".tmp" );
+
+    QFile file( tempName );
+    if ( !file.open( QIODevice::WriteOnly | QIODevice::Truncate ) )
+        return false;
+
+    QDataStream stream( &file );
+    stream << CheckpointMagic << CheckpointVersion << m_parameters << (qint32)progress << state;
+
+    file.close();
+
+    if ( stream.status() != QDataStream::Ok || file.error() != QFile::NoError ) {
+        file.remove();
+        return false;
+    }
+
+    QFile::remove( m_fileName );
+
+    if ( !QFile::rename( tempName, m_fileName ) )
+        return false;
+
+    m_progress = progress;
+    m_state = state;
+
+    return true;
+}
+
+void Checkpoint::remove()
+{
+    QFile::remove( m_fileName );
+
+    m_progress = 0;
+    m_state.clear();
+}
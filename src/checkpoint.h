@@ -0,0 +1,59 @@
+/**************************************************************************
+* This file is part of the Fraqtive program
+* Copyright (C) 2004-2012 Michał Męciński
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**************************************************************************/
+
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <QByteArray>
+#include <QString>
+#include <QTime>
+
+// stores the progress of a long export next to the output file, so that
+// the export can be continued after it was canceled or interrupted
+class Checkpoint
+{
+public:
+    Checkpoint( const QString& outputFileName );
+    ~Checkpoint();
+
+public:
+    void setParameters( const QByteArray& parameters );
+
+    bool load();
+
+    int progress() const { return m_progress; }
+    QByteArray state() const { return m_state; }
+
+    bool isDue() const;
+
+    bool save( int progress, const QByteArray& state = QByteArray() );
+
+    void remove();
+
+private:
+    QString m_fileName;
+
+    QByteArray m_parameters;
+
+    int m_progress;
+    QByteArray m_state;
+
+    QTime m_time;
+};
+
+#endif
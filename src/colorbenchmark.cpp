@@ -0,0 +1,170 @@
+/**************************************************************************
+* This file is part of the Fraqtive program
+* Copyright (C) 2004-2012 Michał Męciński
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**************************************************************************/
+
+#include "colorbenchmark.h"
+
+#include <QImage>
+#include <QStringList>
+#include <QTime>
+#include <QVector>
+
+#include <stdio.h>
+#include <string.h>
+
+#include "datafunctions.h"
+#include "fractaldata.h"
+
+// the values are generated with a fixed seed so that all runs color the same image
+class RandomGenerator
+{
+public:
+    RandomGenerator( quint32 seed ) :
+        m_state( seed )
+    {
+    }
+
+    quint32 next()
+    {
+        m_state ^= m_state << 13;
+        m_state ^= m_state >> 17;
+        m_state ^= m_state << 5;
+        return m_state;
+    }
+
+    double nextDouble()
+    {
+        return (double)next() / 4294967296.0;
+    }
+
+private:
+    quint32 m_state;
+};
+
+static const quint32 RandomSeed = 2463534242u;
+
+ColorBenchmark::ColorBenchmark() :
+    m_resolution( 1920, 1080 )
+{
+}
+
+ColorBenchmark::~ColorBenchmark()
+{
+}
+
+bool ColorBenchmark::isBenchmark( int argc, char** argv )
+{
+    for ( int i = 1; i < argc; i++ ) {
+        if ( !strcmp( argv[ i ], "--benchmark" ) )
+            return true;
+    }
+    return false;
+}
+
+int ColorBenchmark::exec( int argc, char** argv )
+{
+    if ( !parseArguments( argc, argv ) )
+        return 2;
+
+    run();
+
+    return 0;
+}
+
+bool ColorBenchmark::parseArguments( int argc, char** argv )
+{
+    for ( int i = 1; i < argc; i++ ) {
+        if ( !strcmp( argv[ i ], "--benchmark" ) )
+            continue;
+
+        if ( !strcmp( argv[ i ], "--size" ) && i + 1 < argc ) {
+            QStringList parts = QString::fromLocal8Bit( argv[ ++i ] ).split( QLatin1Char( 'x' ) );
+            if ( parts.count() == 2 ) {
+                bool ok1, ok2;
+                m_resolution = QSize( parts.at( 0 ).toInt( &ok1 ), parts.at( 1 ).toInt( &ok2 ) );
+                if ( ok1 && ok2 && m_resolution.width() > 0 && m_resolution.height() > 0 )
+                    continue;
+            }
+        }
+
+        printUsage();
+        return false;
+    }
+
+    return true;
+}
+
+void ColorBenchmark::run()
+{
+    int width = m_resolution.width();
+    int height = m_resolution.height();
+
+    // random values with some background points instead of a calculated image
+    int stride = width + 2;
+    QVector<double> buffer( stride * ( height + 2 ) );
+
+    RandomGenerator random( RandomSeed );
+    for ( int i = 0; i < buffer.count(); i++ )
+        buffer[ i ] = ( random.next() % 8 == 0 ) ? 0.0 : 1000.0 * random.nextDouble();
+
+    FractalData data;
+    data.setBuffer( buffer.data(), stride, QSize( width + 2, height + 2 ) );
+
+    QVector<QRgb> cache( DataFunctions::GradientSize );
+    DataFunctions::fillGradientCache( DataFunctions::defaultGradient(), cache.data(), cache.count() );
+
+    DataFunctions::ColorMapper mapper( cache.constData(), cache.count(), qRgb( 0, 0, 0 ), DataFunctions::defaultColorMapping() );
+
+    QImage image( width, height, QImage::Format_RGB32 );
+
+    const char* kernels = "scalar";
+#if defined( HAVE_SSE2 )
+    if ( GeneratorCore::isSSE2Available() )
+        kernels = "SSE2";
+#endif
+#if defined( HAVE_AVX2 )
+    if ( GeneratorCore::isAVX2Available() )
+        kernels = "AVX2";
+#endif
+
+    fprintf( stdout, "coloring %dx%d images using %s kernels\n", width, height, kernels );
+
+    static const char* const levels[] = { "none", "low", "medium", "high" };
+
+    for ( int level = NoAntiAliasing; level <= HighAntiAliasing; level++ ) {
+        QTime time;
+        time.start();
+
+        // repeat for at least a second to get a stable result
+        int frames = 0;
+        do {
+            DataFunctions::drawImage( image, &data, image.rect(), mapper, (AntiAliasing)level );
+            frames++;
+        } while ( time.elapsed() < 1000 );
+
+        double frameTime = time.elapsed() / (double)frames;
+
+        fprintf( stdout, "anti-aliasing %-6s %8.2f ms per image, %7.1f Mpixels/s\n", levels[ level ], frameTime,
+            width * height / ( 1000.0 * frameTime ) );
+    }
+}
+
+void ColorBenchmark::printUsage() const
+{
+    fprintf( stderr, "usage: fraqtive --benchmark [--size WIDTHxHEIGHT]\n"
+        "  --size WIDTHxHEIGHT      resolution (default 1920x1080)\n" );
+}
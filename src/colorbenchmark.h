@@ -0,0 +1,47 @@
+/**************************************************************************
+* This file is part of the Fraqtive program
+* Copyright (C) 2004-2012 Michał Męciński
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**************************************************************************/
+
+#ifndef COLORBENCHMARK_H
+#define COLORBENCHMARK_H
+
+#include <QSize>
+
+// measures the speed of coloring images using the kernels selected for the processor
+class ColorBenchmark
+{
+public:
+    ColorBenchmark();
+    ~ColorBenchmark();
+
+public:
+    static bool isBenchmark( int argc, char** argv );
+
+    int exec( int argc, char** argv );
+
+private:
+    bool parseArguments( int argc, char** argv );
+
+    void run();
+
+    void printUsage() const;
+
+private:
+    QSize m_resolution;
+};
+
+#endif
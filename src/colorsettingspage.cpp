@@ -91,6 +91,21 @@ void ColorSettingsPage::on_checkReversed_toggled()
     saveMapping();
 }
 
+void ColorSettingsPage::on_radioSquareRoot_clicked()
+{
+    saveMapping();
+}
+
+void ColorSettingsPage::on_radioLinear_clicked()
+{
+    saveMapping();
+}
+
+void ColorSettingsPage::on_radioLogarithmic_clicked()
+{
+    saveMapping();
+}
+
 void ColorSettingsPage::on_buttonRestore_clicked()
 {
     m_model->loadDefaultColorSettings();
@@ -151,6 +166,20 @@ void ColorSettingsPage::loadGradient()
 void ColorSettingsPage::loadMapping()
 {
     ColorMapping mapping = m_model->colorMapping();
+
+    // the transform is loaded first because changing the sliders saves the mapping
+    switch ( mapping.transform() ) {
+        case SquareRootTransform:
+            m_ui.radioSquareRoot->setChecked( true );
+            break;
+        case LinearTransform:
+            m_ui.radioLinear->setChecked( true );
+            break;
+        case LogarithmicTransform:
+            m_ui.radioLogarithmic->setChecked( true );
+            break;
+    }
+
     m_ui.sliderScale->setScaledValue( mapping.scale() );
     m_ui.sliderOffset->setScaledValue( mapping.offset() );
     m_ui.checkMirrored->setChecked( mapping.isMirrored() );
@@ -164,6 +193,12 @@ void ColorSettingsPage::saveMapping()
     mapping.setOffset( m_ui.sliderOffset->scaledValue() );
     mapping.setMirrored( m_ui.checkMirrored->isChecked() );
     mapping.setReversed( m_ui.checkReversed->isChecked() );
+    if ( m_ui.radioLinear->isChecked() )
+        mapping.setTransform( LinearTransform );
+    else if ( m_ui.radioLogarithmic->isChecked() )
+        mapping.setTransform( LogarithmicTransform );
+    else
+        mapping.setTransform( SquareRootTransform );
     m_model->setColorMapping( mapping );
 }
 
@@ -44,6 +44,9 @@ private slots:
     void on_sliderOffset_valueChanged();
     void on_checkMirrored_toggled();
     void on_checkReversed_toggled();
+    void on_radioSquareRoot_clicked();
+    void on_radioLinear_clicked();
+    void on_radioLogarithmic_clicked();
 
     void on_buttonRestore_clicked();
     void on_buttonStore_clicked();
@@ -114,7 +114,7 @@ bool ConfigurationData::readFile( QFile* file, QDataStream* stream, const QStrin
     qint32 version;
     *stream >> version;
 
-    if ( version < 1 || version > 2 )
+    if ( version < 1 || version > 4 )
         return false;
 
     m_dataVersion = version;
@@ -155,7 +155,7 @@ bool ConfigurationData::writeFile( QFile* file, QDataStream* stream, const QStri
     stream->setVersion( QDataStream::Qt_4_2 );
 
     // increment version when adding / modifying fields
-    m_dataVersion = 2;
+    m_dataVersion = 4;
 
     *stream << (qint32)m_dataVersion;
 
@@ -19,7 +19,20 @@
 #include "datafunctions.h"
 #include "fractaldata.h"
 
+#include <QImage>
+#include <QMutex>
 #include <QPainterPath>
+#include <QVector>
+
+#include <math.h>
+
+#ifndef M_PI
+# define M_PI 3.14159265358979323846
+#endif
+
+#if defined( HAVE_SSE2 )
+# include <emmintrin.h>
+#endif
 
 namespace DataFunctions
 {
@@ -216,6 +229,80 @@ void fillGradientCache( const Gradient& gradient, QRgb* cache, int size )
     }
 }
 
+struct SharedGradientCache
+{
+    uint m_hash;
+    Gradient m_gradient;
+    int m_size;
+    QVector<QRgb> m_cache;
+};
+
+static QMutex sharedGradientCachesMutex;
+static QList<SharedGradientCache> sharedGradientCaches;
+
+// the most recently used caches are kept for quickly switching between gradients
+static const int MaxGradientCaches = 8;
+
+static uint hashPolygon( const QPolygonF& polygon )
+{
+    return qHash( QByteArray::fromRawData( reinterpret_cast<const char*>( polygon.constData() ), polygon.count() * sizeof( QPointF ) ) );
+}
+
+static uint hashGradient( const Gradient& gradient, int size )
+{
+    return hashPolygon( gradient.red() ) ^ ( hashPolygon( gradient.green() ) << 1 ) ^ ( hashPolygon( gradient.blue() ) << 2 ) ^ size;
+}
+
+static int findGradientCache( uint hash, const Gradient& gradient, int size )
+{
+    for ( int i = 0; i < sharedGradientCaches.count(); i++ ) {
+        const SharedGradientCache& shared = sharedGradientCaches.at( i );
+        if ( shared.m_hash == hash && shared.m_size == size && shared.m_gradient == gradient )
+            return i;
+    }
+    return -1;
+}
+
+QVector<QRgb> sharedGradientCache( const Gradient& gradient, int size )
+{
+    uint hash = hashGradient( gradient, size );
+
+    QMutexLocker locker( &sharedGradientCachesMutex );
+
+    int index = findGradientCache( hash, gradient, size );
+    if ( index >= 0 ) {
+        // move to the front so that recently used caches are removed last
+        sharedGradientCaches.move( index, 0 );
+        return sharedGradientCaches.first().m_cache;
+    }
+
+    locker.unlock();
+
+    SharedGradientCache shared;
+    shared.m_hash = hash;
+    shared.m_gradient = gradient;
+    shared.m_size = size;
+    shared.m_cache.resize( size );
+    fillGradientCache( gradient, shared.m_cache.data(), size );
+
+    locker.relock();
+
+    // another thread could have filled the same cache in the meantime
+    index = findGradientCache( hash, gradient, size );
+    if ( index >= 0 ) {
+        sharedGradientCaches.move( index, 0 );
+        return sharedGradientCaches.first().m_cache;
+    }
+
+    sharedGradientCaches.prepend( shared );
+
+    // removed caches remain valid for their users because the vectors are implicitly shared
+    while ( sharedGradientCaches.count() > MaxGradientCaches )
+        sharedGradientCaches.removeLast();
+
+    return shared.m_cache;
+}
+
 ColorMapper::ColorMapper( const QRgb* gradientCache, int gradientSize, QRgb backgroundColor, const ColorMapping& mapping ) :
     m_gradientCache( gradientCache ),
     m_gradientSize( gradientSize ),
@@ -224,11 +311,30 @@ ColorMapper::ColorMapper( const QRgb* gradientCache, int gradientSize, QRgb back
 {
 }
 
+// the generated values are square roots of the smoothed iteration counts;
+// the other transforms match their slope at about 400 iterations
+static const double LinearFactor = 1.0 / 40.0;
+static const double LogarithmicFactor = 10.0;
+
+double transformValue( double value, ValueTransform transform )
+{
+    switch ( transform ) {
+        case LinearTransform:
+            return LinearFactor * value * value;
+        case LogarithmicTransform:
+            return LogarithmicFactor * log( 1.0 + value * value );
+        default:
+            return value;
+    }
+}
+
 QRgb ColorMapper::map( double value ) const
 {
     if ( value == 0.0 )
         return m_backgroundColor;
 
+    value = transformValue( value, m_mapping.transform() );
+
     int index;
     if ( m_mapping.isMirrored() ) {
         int scaled = (int)( ( m_mapping.scale() * value + 2 * m_mapping.offset() ) * m_gradientSize );
@@ -246,6 +352,94 @@ QRgb ColorMapper::map( double value ) const
     return m_gradientCache[ index ];
 }
 
+void ColorMapper::mapRow( QRgb* colors, const double* values, int count ) const
+{
+#if defined( HAVE_AVX2 )
+    if ( GeneratorCore::isAVX2Available() ) {
+        mapRowAVX2( colors, values, count );
+        return;
+    }
+#endif
+
+#if defined( HAVE_SSE2 )
+    if ( GeneratorCore::isSSE2Available() ) {
+        mapRowSSE2( colors, values, count );
+        return;
+    }
+#endif
+
+    for ( int x = 0; x < count; x++ )
+        colors[ x ] = map( values[ x ] );
+}
+
+#if defined( HAVE_SSE2 )
+
+void ColorMapper::mapRowSSE2( QRgb* colors, const double* values, int count ) const
+{
+    bool mirrored = m_mapping.isMirrored();
+    int period = mirrored ? 2 * m_gradientSize : m_gradientSize;
+
+    __m128d scale = _mm_set1_pd( m_mapping.scale() );
+    __m128d offset = _mm_set1_pd( mirrored ? 2 * m_mapping.offset() : m_mapping.offset() );
+    __m128d size = _mm_set1_pd( m_gradientSize );
+    __m128d zero = _mm_setzero_pd();
+
+    __m128d periodPD = _mm_set1_pd( period );
+    __m128d inversePeriodPD = _mm_set1_pd( 1.0 / period );
+
+    __m128i periodPI = _mm_set1_epi32( period );
+    __m128i lastPeriodPI = _mm_set1_epi32( period - 1 );
+    __m128i lastIndexPI = _mm_set1_epi32( m_gradientSize - 1 );
+    __m128i zeroPI = _mm_setzero_si128();
+
+    ValueTransform transform = m_mapping.transform();
+
+    int index[ 2 ];
+
+    int x = 0;
+    for ( ; x + 2 <= count; x += 2 ) {
+        __m128d value = _mm_loadu_pd( values + x );
+
+        __m128d transformed = value;
+        if ( transform != SquareRootTransform )
+            transformed = _mm_set_pd( transformValue( values[ x + 1 ], transform ), transformValue( values[ x ], transform ) );
+
+        // same order of operations as in map() to get identical rounding
+        __m128d scaled = _mm_mul_pd( _mm_add_pd( _mm_mul_pd( scale, transformed ), offset ), size );
+        __m128i truncated = _mm_cvttpd_epi32( scaled );
+
+        // there is no integer division, so calculate the remainder using doubles
+        __m128d truncatedPD = _mm_cvtepi32_pd( truncated );
+        __m128d quotient = _mm_cvtepi32_pd( _mm_cvttpd_epi32( _mm_mul_pd( truncatedPD, inversePeriodPD ) ) );
+        __m128i remainder = _mm_cvttpd_epi32( _mm_sub_pd( truncatedPD, _mm_mul_pd( quotient, periodPD ) ) );
+
+        // fix off by one errors caused by the inexact reciprocal
+        remainder = _mm_sub_epi32( remainder, _mm_and_si128( _mm_cmpgt_epi32( remainder, lastPeriodPI ), periodPI ) );
+        remainder = _mm_add_epi32( remainder, _mm_and_si128( _mm_cmplt_epi32( remainder, zeroPI ), periodPI ) );
+
+        if ( mirrored ) {
+            __m128i mask = _mm_cmpgt_epi32( remainder, lastIndexPI );
+            __m128i reflected = _mm_sub_epi32( lastPeriodPI, remainder );
+            remainder = _mm_or_si128( _mm_and_si128( mask, reflected ), _mm_andnot_si128( mask, remainder ) );
+        }
+
+        if ( m_mapping.isReversed() )
+            remainder = _mm_sub_epi32( lastIndexPI, remainder );
+
+        _mm_storel_epi64( reinterpret_cast<__m128i*>( index ), remainder );
+
+        int background = _mm_movemask_pd( _mm_cmpeq_pd( value, zero ) );
+
+        colors[ x ] = ( background & 1 ) ? m_backgroundColor : m_gradientCache[ index[ 0 ] ];
+        colors[ x + 1 ] = ( background & 2 ) ? m_backgroundColor : m_gradientCache[ index[ 1 ] ];
+    }
+
+    for ( ; x < count; x++ )
+        colors[ x ] = map( values[ x ] );
+}
+
+#endif // defined( HAVE_SSE2 )
+
 template<int A, int B, int C>
 static inline QRgb maskedSum( QRgb color[ 3 ][ 3 ], int mask )
 {
@@ -264,56 +458,358 @@ static inline QRgb calcAntiAliased( QRgb color[ 3 ][ 3 ] )
 }
 
 template<int A, int B, int C>
-static void drawAntiAliased( QImage& image, const QPoint& point, const FractalData* data, const QRect& region, const ColorMapper& mapper )
+static inline void antiAliasRow( QRgb* dest, QRgb* rows[ 3 ], int width )
 {
     QRgb color[ 3 ][ 3 ];
 
-    int stride = data->stride();
-    int width = region.width();
+    for ( int x = 0; x < width; x++ ) {
+        for ( int i = 0; i < 3; i++ ) {
+            color[ i ][ 0 ] = rows[ i ][ x ];
+            color[ i ][ 1 ] = rows[ i ][ x + 1 ];
+            color[ i ][ 2 ] = rows[ i ][ x + 2 ];
+        }
+        dest[ x ] = calcAntiAliased<A, B, C>( color );
+    }
+}
 
-    for ( int y = 0; y < region.height(); y++ ) {
-        const double* src = data->buffer() + ( y + region.top() ) * stride + region.left() ;
-        QRgb* dest = reinterpret_cast<QRgb*>( image.scanLine( y + point.y() ) ) + point.x();
+#if defined( HAVE_SSE2 )
 
-        for ( int i = 0; i < 3; i++ ) {
-            color[ i ][ 1 ] = mapper.map( src[ i * stride ] );
-            color[ i ][ 2 ] = mapper.map( src[ i * stride + 1 ] );
+static inline __m128i loadPixelsSSE2( const QRgb* pixels )
+{
+    // unpack two adjacent pixels to 16-bit channels
+    return _mm_unpacklo_epi8( _mm_loadl_epi64( reinterpret_cast<const __m128i*>( pixels ) ), _mm_setzero_si128() );
+}
+
+template<int A, int B, int C>
+static inline void antiAliasRowSSE2( QRgb* dest, QRgb* rows[ 3 ], int width )
+{
+    __m128i alpha = _mm_set1_epi32( 0xff000000 );
+
+    int x = 0;
+    for ( ; x + 2 <= width; x += 2 ) {
+        // the weighted sum never exceeds 16 * 255, so it fits in 16-bit channels
+        __m128i sum = _mm_mullo_epi16( loadPixelsSSE2( rows[ 1 ] + x + 1 ), _mm_set1_epi16( A ) );
+
+        if ( B != 0 ) {
+            __m128i sides = _mm_add_epi16( _mm_add_epi16( loadPixelsSSE2( rows[ 0 ] + x + 1 ), loadPixelsSSE2( rows[ 2 ] + x + 1 ) ),
+                _mm_add_epi16( loadPixelsSSE2( rows[ 1 ] + x ), loadPixelsSSE2( rows[ 1 ] + x + 2 ) ) );
+            sum = _mm_add_epi16( sum, _mm_mullo_epi16( sides, _mm_set1_epi16( B ) ) );
         }
 
-        for ( int x = 0; x < width; x++ ) {
-            for ( int i = 0; i < 3; i++ ) {
-                color[ i ][ 0 ] = color[ i ][ 1 ];
-                color[ i ][ 1 ] = color[ i ][ 2 ];
-                color[ i ][ 2 ] = mapper.map( src[ i * stride + x + 2 ] );
-            }
-            dest[ x ] = calcAntiAliased<A, B, C>( color );
+        if ( C != 0 ) {
+            __m128i corners = _mm_add_epi16( _mm_add_epi16( loadPixelsSSE2( rows[ 0 ] + x ), loadPixelsSSE2( rows[ 0 ] + x + 2 ) ),
+                _mm_add_epi16( loadPixelsSSE2( rows[ 2 ] + x ), loadPixelsSSE2( rows[ 2 ] + x + 2 ) ) );
+            sum = _mm_add_epi16( sum, _mm_mullo_epi16( corners, _mm_set1_epi16( C ) ) );
         }
+
+        __m128i result = _mm_packus_epi16( _mm_srli_epi16( sum, 4 ), _mm_setzero_si128() );
+        _mm_storel_epi64( reinterpret_cast<__m128i*>( dest + x ), _mm_or_si128( result, alpha ) );
+    }
+
+    if ( x < width ) {
+        QRgb* tail[ 3 ] = { rows[ 0 ] + x, rows[ 1 ] + x, rows[ 2 ] + x };
+        antiAliasRow<A, B, C>( dest + x, tail, width - x );
     }
 }
 
-void drawImage( QImage& image, const FractalData* data, const QRect& region, const ColorMapper& mapper, AntiAliasing antiAliasing )
+#endif // defined( HAVE_SSE2 )
+
+class ValueRowMapper
 {
-    drawImage( image, region.topLeft(), data, region, mapper, antiAliasing );
+public:
+    ValueRowMapper( const double* buffer, int stride, const ColorMapper& mapper ) :
+        m_buffer( buffer ),
+        m_stride( stride ),
+        m_mapper( mapper )
+    {
+    }
+
+    void mapRow( QRgb* colors, int x, int y, int count ) const
+    {
+        m_mapper.mapRow( colors, m_buffer + y * m_stride + x, count );
+    }
+
+private:
+    const double* m_buffer;
+    int m_stride;
+    const ColorMapper& m_mapper;
+};
+
+class IndexRowMapper
+{
+public:
+    IndexRowMapper( const int* indexes, int stride, const QRgb* palette ) :
+        m_indexes( indexes ),
+        m_stride( stride ),
+        m_palette( palette )
+    {
+    }
+
+    void mapRow( QRgb* colors, int x, int y, int count ) const
+    {
+        const int* src = m_indexes + y * m_stride + x;
+        for ( int i = 0; i < count; i++ )
+            colors[ i ] = m_palette[ src[ i ] ];
+    }
+
+private:
+    const int* m_indexes;
+    int m_stride;
+    const QRgb* m_palette;
+};
+
+template<int A, int B, int C, class RowMapper>
+static void drawAntiAliased( QImage& image, const QPoint& point, const RowMapper& mapper, const QRect& region )
+{
+    int width = region.width();
+
+    // without anti-aliasing only the middle row and column are used
+    if ( B == 0 && C == 0 ) {
+        for ( int y = 0; y < region.height(); y++ ) {
+            QRgb* dest = reinterpret_cast<QRgb*>( image.scanLine( y + point.y() ) ) + point.x();
+            mapper.mapRow( dest, region.left() + 1, region.top() + y + 1, width );
+        }
+        return;
+    }
+
+    // colors of three consecutive source rows are cached so that each value is mapped only once
+    QVector<QRgb> cache( 3 * ( width + 2 ) );
+
+    QRgb* rows[ 3 ];
+    for ( int i = 0; i < 3; i++ )
+        rows[ i ] = cache.data() + i * ( width + 2 );
+
+    mapper.mapRow( rows[ 1 ], region.left(), region.top(), width + 2 );
+    mapper.mapRow( rows[ 2 ], region.left(), region.top() + 1, width + 2 );
+
+#if defined( HAVE_SSE2 )
+    bool useSSE2 = GeneratorCore::isSSE2Available();
+#endif
+#if defined( HAVE_AVX2 )
+    bool useAVX2 = GeneratorCore::isAVX2Available();
+#endif
+
+    for ( int y = 0; y < region.height(); y++ ) {
+        QRgb* recycled = rows[ 0 ];
+        rows[ 0 ] = rows[ 1 ];
+        rows[ 1 ] = rows[ 2 ];
+        rows[ 2 ] = recycled;
+
+        mapper.mapRow( rows[ 2 ], region.left(), region.top() + y + 2, width + 2 );
+
+        QRgb* dest = reinterpret_cast<QRgb*>( image.scanLine( y + point.y() ) ) + point.x();
+
+#if defined( HAVE_AVX2 )
+        if ( useAVX2 ) {
+            int x = antiAliasRowAVX2<A, B, C>( dest, rows, width );
+            QRgb* tail[ 3 ] = { rows[ 0 ] + x, rows[ 1 ] + x, rows[ 2 ] + x };
+            antiAliasRow<A, B, C>( dest + x, tail, width - x );
+            continue;
+        }
+#endif
+
+#if defined( HAVE_SSE2 )
+        if ( useSSE2 ) {
+            antiAliasRowSSE2<A, B, C>( dest, rows, width );
+            continue;
+        }
+#endif
+
+        antiAliasRow<A, B, C>( dest, rows, width );
+    }
 }
 
-void drawImage( QImage& image, const QPoint& point, const FractalData* data, const QRect& region, const ColorMapper& mapper, AntiAliasing antiAliasing )
+template<class RowMapper>
+static void drawRows( QImage& image, const QPoint& point, const RowMapper& mapper, const QRect& region, AntiAliasing antiAliasing )
 {
     switch ( antiAliasing ) {
         case NoAntiAliasing:
-            drawAntiAliased<16, 0, 0>( image, point, data, region, mapper );
+            drawAntiAliased<16, 0, 0>( image, point, mapper, region );
             break;
         case LowAntiAliasing:
-            drawAntiAliased<12, 1, 0>( image, point, data, region, mapper );
+            drawAntiAliased<12, 1, 0>( image, point, mapper, region );
             break;
         case MediumAntiAliasing:
-            drawAntiAliased<8, 1, 1>( image, point, data, region, mapper );
+            drawAntiAliased<8, 1, 1>( image, point, mapper, region );
             break;
         case HighAntiAliasing:
-            drawAntiAliased<4, 2, 1>( image, point, data, region, mapper );
+            drawAntiAliased<4, 2, 1>( image, point, mapper, region );
             break;
     }
 }
 
+void drawImage( QImage& image, const FractalData* data, const QRect& region, const ColorMapper& mapper, AntiAliasing antiAliasing )
+{
+    drawImage( image, region.topLeft(), data, region, mapper, antiAliasing );
+}
+
+void drawImage( QImage& image, const QPoint& point, const FractalData* data, const QRect& region, const ColorMapper& mapper, AntiAliasing antiAliasing )
+{
+    ValueRowMapper rowMapper( data->buffer(), data->stride(), mapper );
+    drawRows( image, point, rowMapper, region, antiAliasing );
+}
+
+int colorPaletteSize( int gradientSize, const ColorMapping& mapping )
+{
+    return ( mapping.isMirrored() ? 2 * gradientSize : gradientSize ) + 1;
+}
+
+void fillColorIndexes( int* indexes, const double* values, int count, int gradientSize, const ColorMapping& mapping )
+{
+    bool mirrored = mapping.isMirrored();
+    int period = mirrored ? 2 * gradientSize : gradientSize;
+    double offset = mirrored ? 2 * mapping.offset() : mapping.offset();
+    ValueTransform transform = mapping.transform();
+
+    // the first entry of the palette is the background color
+    for ( int x = 0; x < count; x++ ) {
+        if ( values[ x ] == 0.0 )
+            indexes[ x ] = 0;
+        else
+            indexes[ x ] = (int)( ( mapping.scale() * transformValue( values[ x ], transform ) + offset ) * gradientSize ) % period + 1;
+    }
+}
+
+static inline QRgb paletteColor( int position, int shift, const QRgb* gradientCache, int gradientSize, int period, bool reversed )
+{
+    int index = ( position + shift ) % period;
+    if ( index >= gradientSize )
+        index = period - index - 1;
+    if ( reversed )
+        index = gradientSize - index - 1;
+    return gradientCache[ index ];
+}
+
+void fillColorPalette( QRgb* palette, const QRgb* gradientCache, int gradientSize, QRgb backgroundColor, const ColorMapping& mapping, double scrolling )
+{
+    bool mirrored = mapping.isMirrored();
+    int period = mirrored ? 2 * gradientSize : gradientSize;
+
+    // scrolling the colors only rotates the palette
+    int shift = (int)( scrolling * period ) % period;
+
+    palette[ 0 ] = backgroundColor;
+
+    for ( int i = 0; i < period; i++ )
+        palette[ i + 1 ] = paletteColor( i, shift, gradientCache, gradientSize, period, mapping.isReversed() );
+}
+
+void drawImage( QImage& image, const QPoint& point, const int* indexes, int stride, const QRect& region, const QRgb* palette, AntiAliasing antiAliasing )
+{
+    IndexRowMapper rowMapper( indexes, stride, palette );
+    drawRows( image, point, rowMapper, region, antiAliasing );
+}
+
+void drawIndexImage( QImage& image, const QPoint& point, const int* indexes, int stride, const QRect& region, int paletteSize )
+{
+    int period = paletteSize - 1;
+
+    // each entry of the color table stands for an equal part of the palette
+    for ( int y = 0; y < region.height(); y++ ) {
+        uchar* dest = image.scanLine( y + point.y() ) + point.x();
+        const int* src = indexes + ( region.top() + y + 1 ) * stride + region.left() + 1;
+        for ( int x = 0; x < region.width(); x++ )
+            dest[ x ] = src[ x ] == 0 ? 0 : (uchar)( 1 + (qint64)( src[ x ] - 1 ) * ( ColorTableSize - 1 ) / period );
+    }
+}
+
+void fillColorTable( QRgb* table, const QRgb* gradientCache, int gradientSize, QRgb backgroundColor, const ColorMapping& mapping, double scrolling )
+{
+    bool mirrored = mapping.isMirrored();
+    int period = mirrored ? 2 * gradientSize : gradientSize;
+
+    int shift = (int)( scrolling * period ) % period;
+
+    table[ 0 ] = backgroundColor;
+
+    // each entry gets the color from the middle of its part of the rotated palette
+    for ( int i = 1; i < ColorTableSize; i++ ) {
+        int position = (int)( (qint64)( 2 * i - 1 ) * period / ( 2 * ( ColorTableSize - 1 ) ) );
+        table[ i ] = paletteColor( position, shift, gradientCache, gradientSize, period, mapping.isReversed() );
+    }
+}
+
+static inline void accumulateRow( quint16* sums, const QRgb* pixels, int count )
+{
+    const uchar* bytes = reinterpret_cast<const uchar*>( pixels );
+    for ( int i = 0; i < 4 * count; i++ )
+        sums[ i ] += bytes[ i ];
+}
+
+#if defined( HAVE_SSE2 )
+
+static inline void accumulateRowSSE2( quint16* sums, const QRgb* pixels, int count )
+{
+    __m128i zero = _mm_setzero_si128();
+
+    int x = 0;
+    for ( ; x + 4 <= count; x += 4 ) {
+        __m128i colors = _mm_loadu_si128( reinterpret_cast<const __m128i*>( pixels + x ) );
+        __m128i* sum = reinterpret_cast<__m128i*>( sums + 4 * x );
+        _mm_storeu_si128( sum, _mm_add_epi16( _mm_loadu_si128( sum ), _mm_unpacklo_epi8( colors, zero ) ) );
+        _mm_storeu_si128( sum + 1, _mm_add_epi16( _mm_loadu_si128( sum + 1 ), _mm_unpackhi_epi8( colors, zero ) ) );
+    }
+
+    if ( x < count )
+        accumulateRow( sums + 4 * x, pixels + x, count - x );
+}
+
+#endif // defined( HAVE_SSE2 )
+
+QImage downsampleImage( const QImage& image, int multiSampling )
+{
+    if ( multiSampling == 0 )
+        return image;
+
+    int factor = 1 << multiSampling;
+
+    int width = image.width() >> multiSampling;
+    int height = image.height() >> multiSampling;
+
+    QImage result( width, height, QImage::Format_RGB32 );
+
+#if defined( HAVE_SSE2 )
+    bool useSSE2 = GeneratorCore::isSSE2Available();
+#endif
+
+    // the sum of 8 x 8 pixels never exceeds 64 * 255, so it fits in 16-bit channels
+    QVector<quint16> sums( 4 * width * factor );
+    int round = 1 << ( 2 * multiSampling - 1 );
+
+    for ( int y = 0; y < height; y++ ) {
+        sums.fill( 0 );
+
+        for ( int i = 0; i < factor; i++ ) {
+            const QRgb* source = reinterpret_cast<const QRgb*>( image.scanLine( ( y << multiSampling ) + i ) );
+#if defined( HAVE_SSE2 )
+            if ( useSSE2 ) {
+                accumulateRowSSE2( sums.data(), source, width * factor );
+                continue;
+            }
+#endif
+            accumulateRow( sums.data(), source, width * factor );
+        }
+
+        QRgb* dest = reinterpret_cast<QRgb*>( result.scanLine( y ) );
+        const quint16* sum = sums.constData();
+
+        for ( int x = 0; x < width; x++ ) {
+            // channels are summed in the byte order of the pixels
+            int channels[ 4 ] = { round, round, round, round };
+            for ( int j = 0; j < factor; j++, sum += 4 ) {
+                for ( int k = 0; k < 4; k++ )
+                    channels[ k ] += sum[ k ];
+            }
+
+            uchar* bytes = reinterpret_cast<uchar*>( dest + x );
+            for ( int k = 0; k < 4; k++ )
+                bytes[ k ] = channels[ k ] >> ( 2 * multiSampling );
+        }
+    }
+
+    return result;
+}
+
 GeneratorCore::Functor* createFunctor( const FractalType& type )
 {
     switch ( type.exponentType() ) {
@@ -339,6 +835,88 @@ GeneratorCore::Functor* createFunctor( const FractalType& type )
     return NULL;
 }
 
+static const int ProbeSize = 48;
+static const int ProbeRange = 16;
+static const double ProbeTolerance = 0.002;
+
+int estimateIterations( const FractalType& type, const Position& position, const QSize& resolution, int iterations,
+    QVector<int>* histogram )
+{
+    GeneratorCore::Functor* functor = createFunctor( type );
+    if ( !functor || resolution.isEmpty() )
+        return iterations;
+
+    // probe a coarse grid of points covering the whole view
+    int width = ProbeSize;
+    int height = qMax( ProbeSize * resolution.height() / resolution.width(), 1 );
+    double step = (double)resolution.width() / (double)width;
+
+    double scale = step * pow( 10.0, -position.zoomFactor() ) / (double)resolution.height();
+
+    double sa = scale * sin( position.angle() * M_PI / 180.0 );
+    double ca = scale * cos( position.angle() * M_PI / 180.0 );
+
+    double offsetX = 0.5 - (double)width / 2.0;
+    double offsetY = 0.5 - (double)height / 2.0;
+
+    GeneratorCore::Input input;
+    input.m_sa = sa;
+    input.m_ca = ca;
+    input.m_x = position.center().x() + ca * offsetX + sa * offsetY;
+    input.m_y = position.center().y() - sa * offsetX + ca * offsetY;
+
+    QVector<int> buckets( GeneratorCore::HistogramSize );
+
+    int result = GeneratorCore::probeIterations( input, width, height, functor, qMax( iterations / ProbeRange, 64 ),
+        iterations * ProbeRange, ProbeTolerance, buckets.data() );
+
+    delete functor;
+
+    if ( histogram )
+        *histogram = buckets;
+
+    return result;
+}
+
+static const double AngleTolerance = 1e-9;
+
+Symmetry findSymmetry( const FractalType& type, const Position& position, int height, QPointF* center )
+{
+    double scale = pow( 10.0, -position.zoomFactor() ) / (double)height;
+
+    double sa = sin( position.angle() * M_PI / 180.0 );
+    double ca = cos( position.angle() * M_PI / 180.0 );
+
+    double cx = position.center().x();
+    double cy = position.center().y();
+
+    GeneratorCore::Variant variant = type.variant();
+    bool conjugate = variant == GeneratorCore::NormalVariant || variant == GeneratorCore::ConjugateVariant;
+    bool even = type.exponentType() == IntegralExponent && type.integralExponent() % 2 == 0;
+
+    // the reflection about the real axis maps rows onto rows only when the view is not rotated
+    bool mirror;
+    if ( type.fractal() == MandelbrotFractal )
+        mirror = conjugate;
+    else
+        mirror = ( conjugate && type.parameter().y() == 0.0 ) || variant == GeneratorCore::AbsoluteVariant || variant == GeneratorCore::AbsoluteImVariant;
+
+    if ( mirror && fabs( sa ) < AngleTolerance ) {
+        // the center is expressed in pixels relative to the center of the view
+        *center = QPointF( 0.0, -cy / ( ca * scale ) );
+        return MirrorSymmetry;
+    }
+
+    bool point = type.fractal() == JuliaFractal && ( variant == GeneratorCore::AbsoluteVariant || ( conjugate && even ) );
+
+    if ( point ) {
+        *center = QPointF( ( sa * cy - ca * cx ) / scale, -( sa * cx + ca * cy ) / scale );
+        return PointSymmetry;
+    }
+
+    return NoSymmetry;
+}
+
 #if defined( HAVE_SSE2 )
 
 GeneratorCore::FunctorSSE2* createFunctorSSE2( const FractalType& type )
@@ -20,6 +20,7 @@
 #define DATAFUNCTIONS_H
 
 #include <QGradient>
+#include <QVector>
 
 #include "datastructures.h"
 #include "generatorcore.h"
@@ -41,6 +42,15 @@ QGradientStops calculateGradientStops( const Gradient& gradient );
 
 void fillGradientCache( const Gradient& gradient, QRgb* cache, int size );
 
+static const int GradientSize = 16384;
+
+// the number of colors of indexed images, including the background color
+static const int ColorTableSize = 256;
+
+QVector<QRgb> sharedGradientCache( const Gradient& gradient, int size );
+
+double transformValue( double value, ValueTransform transform );
+
 class ColorMapper
 {
 public:
@@ -49,7 +59,16 @@ public:
 public:
     QRgb map( double value ) const;
 
+    void mapRow( QRgb* colors, const double* values, int count ) const;
+
 private:
+#if defined( HAVE_SSE2 )
+    void mapRowSSE2( QRgb* colors, const double* values, int count ) const;
+#endif
+#if defined( HAVE_AVX2 )
+    void mapRowAVX2( QRgb* colors, const double* values, int count ) const;
+#endif
+
     const QRgb* m_gradientCache;
     int m_gradientSize;
 
@@ -58,11 +77,41 @@ private:
     ColorMapping m_mapping;
 };
 
+#if defined( HAVE_AVX2 )
+// returns the number of pixels processed, the remaining ones are processed by the caller
+template<int A, int B, int C>
+int antiAliasRowAVX2( QRgb* dest, QRgb* rows[ 3 ], int width );
+#endif
+
 void drawImage( QImage& image, const FractalData* data, const QRect& region, const ColorMapper& mapper, AntiAliasing antiAliasing );
 void drawImage( QImage& image, const QPoint& point, const FractalData* data, const QRect& region, const ColorMapper& mapper, AntiAliasing antiAliasing );
 
+int colorPaletteSize( int gradientSize, const ColorMapping& mapping );
+
+void fillColorIndexes( int* indexes, const double* values, int count, int gradientSize, const ColorMapping& mapping );
+void fillColorPalette( QRgb* palette, const QRgb* gradientCache, int gradientSize, QRgb backgroundColor, const ColorMapping& mapping, double scrolling );
+
+void drawImage( QImage& image, const QPoint& point, const int* indexes, int stride, const QRect& region, const QRgb* palette, AntiAliasing antiAliasing );
+
+void drawIndexImage( QImage& image, const QPoint& point, const int* indexes, int stride, const QRect& region, int paletteSize );
+void fillColorTable( QRgb* table, const QRgb* gradientCache, int gradientSize, QRgb backgroundColor, const ColorMapping& mapping, double scrolling );
+
+QImage downsampleImage( const QImage& image, int multiSampling );
+
 GeneratorCore::Functor* createFunctor( const FractalType& type );
 
+int estimateIterations( const FractalType& type, const Position& position, const QSize& resolution, int iterations,
+    QVector<int>* histogram );
+
+enum Symmetry
+{
+    NoSymmetry,
+    MirrorSymmetry,
+    PointSymmetry
+};
+
+Symmetry findSymmetry( const FractalType& type, const Position& position, int height, QPointF* center );
+
 #if defined( HAVE_SSE2 )
 
 GeneratorCore::FunctorSSE2* createFunctorSSE2( const FractalType& type );
@@ -0,0 +1,146 @@
+/**************************************************************************
+* This file is part of the Fraqtive program
+* Copyright (C) 2004-2012 Michał Męciński
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**************************************************************************/
+
+#include "datafunctions.h"
+
+#if defined( HAVE_AVX2 )
+
+#include <immintrin.h>
+
+// this file is compiled with AVX2 enabled, so its functions may only be called
+// after checking GeneratorCore::isAVX2Available()
+
+namespace DataFunctions
+{
+
+void ColorMapper::mapRowAVX2( QRgb* colors, const double* values, int count ) const
+{
+    bool mirrored = m_mapping.isMirrored();
+    int period = mirrored ? 2 * m_gradientSize : m_gradientSize;
+
+    __m256d scale = _mm256_set1_pd( m_mapping.scale() );
+    __m256d offset = _mm256_set1_pd( mirrored ? 2 * m_mapping.offset() : m_mapping.offset() );
+    __m256d size = _mm256_set1_pd( m_gradientSize );
+    __m256d zero = _mm256_setzero_pd();
+
+    __m256d periodPD = _mm256_set1_pd( period );
+    __m256d inversePeriodPD = _mm256_set1_pd( 1.0 / period );
+
+    __m128i periodPI = _mm_set1_epi32( period );
+    __m128i lastPeriodPI = _mm_set1_epi32( period - 1 );
+    __m128i lastIndexPI = _mm_set1_epi32( m_gradientSize - 1 );
+    __m128i zeroPI = _mm_setzero_si128();
+
+    __m128i background = _mm_set1_epi32( m_backgroundColor );
+    __m256i evenLanes = _mm256_setr_epi32( 0, 2, 4, 6, 0, 2, 4, 6 );
+
+    const int* cache = reinterpret_cast<const int*>( m_gradientCache );
+
+    ValueTransform transform = m_mapping.transform();
+
+    int x = 0;
+    for ( ; x + 4 <= count; x += 4 ) {
+        __m256d value = _mm256_loadu_pd( values + x );
+
+        __m256d transformed = value;
+        if ( transform != SquareRootTransform ) {
+            transformed = _mm256_setr_pd( transformValue( values[ x ], transform ), transformValue( values[ x + 1 ], transform ),
+                transformValue( values[ x + 2 ], transform ), transformValue( values[ x + 3 ], transform ) );
+        }
+
+        // same order of operations as in map() to get identical rounding
+        __m256d scaled = _mm256_mul_pd( _mm256_add_pd( _mm256_mul_pd( scale, transformed ), offset ), size );
+        __m128i truncated = _mm256_cvttpd_epi32( scaled );
+
+        // there is no integer division, so calculate the remainder using doubles
+        __m256d truncatedPD = _mm256_cvtepi32_pd( truncated );
+        __m256d quotient = _mm256_cvtepi32_pd( _mm256_cvttpd_epi32( _mm256_mul_pd( truncatedPD, inversePeriodPD ) ) );
+        __m128i remainder = _mm256_cvttpd_epi32( _mm256_sub_pd( truncatedPD, _mm256_mul_pd( quotient, periodPD ) ) );
+
+        // fix off by one errors caused by the inexact reciprocal
+        remainder = _mm_sub_epi32( remainder, _mm_and_si128( _mm_cmpgt_epi32( remainder, lastPeriodPI ), periodPI ) );
+        remainder = _mm_add_epi32( remainder, _mm_and_si128( _mm_cmplt_epi32( remainder, zeroPI ), periodPI ) );
+
+        if ( mirrored ) {
+            __m128i mask = _mm_cmpgt_epi32( remainder, lastIndexPI );
+            remainder = _mm_blendv_epi8( remainder, _mm_sub_epi32( lastPeriodPI, remainder ), mask );
+        }
+
+        if ( m_mapping.isReversed() )
+            remainder = _mm_sub_epi32( lastIndexPI, remainder );
+
+        __m128i result = _mm_i32gather_epi32( cache, remainder, 4 );
+
+        // narrow the 64-bit comparison masks to 32-bit lanes
+        __m256i isZero = _mm256_castpd_si256( _mm256_cmp_pd( value, zero, _CMP_EQ_OQ ) );
+        __m128i mask = _mm256_castsi256_si128( _mm256_permutevar8x32_epi32( isZero, evenLanes ) );
+
+        result = _mm_blendv_epi8( result, background, mask );
+
+        _mm_storeu_si128( reinterpret_cast<__m128i*>( colors + x ), result );
+    }
+
+    for ( ; x < count; x++ )
+        colors[ x ] = map( values[ x ] );
+}
+
+static inline __m256i loadPixelsAVX2( const QRgb* pixels )
+{
+    // unpack four adjacent pixels to 16-bit channels
+    return _mm256_cvtepu8_epi16( _mm_loadu_si128( reinterpret_cast<const __m128i*>( pixels ) ) );
+}
+
+template<int A, int B, int C>
+int antiAliasRowAVX2( QRgb* dest, QRgb* rows[ 3 ], int width )
+{
+    __m128i alpha = _mm_set1_epi32( 0xff000000 );
+
+    int x = 0;
+    for ( ; x + 4 <= width; x += 4 ) {
+        // the weighted sum never exceeds 16 * 255, so it fits in 16-bit channels
+        __m256i sum = _mm256_mullo_epi16( loadPixelsAVX2( rows[ 1 ] + x + 1 ), _mm256_set1_epi16( A ) );
+
+        if ( B != 0 ) {
+            __m256i sides = _mm256_add_epi16( _mm256_add_epi16( loadPixelsAVX2( rows[ 0 ] + x + 1 ), loadPixelsAVX2( rows[ 2 ] + x + 1 ) ),
+                _mm256_add_epi16( loadPixelsAVX2( rows[ 1 ] + x ), loadPixelsAVX2( rows[ 1 ] + x + 2 ) ) );
+            sum = _mm256_add_epi16( sum, _mm256_mullo_epi16( sides, _mm256_set1_epi16( B ) ) );
+        }
+
+        if ( C != 0 ) {
+            __m256i corners = _mm256_add_epi16( _mm256_add_epi16( loadPixelsAVX2( rows[ 0 ] + x ), loadPixelsAVX2( rows[ 0 ] + x + 2 ) ),
+                _mm256_add_epi16( loadPixelsAVX2( rows[ 2 ] + x ), loadPixelsAVX2( rows[ 2 ] + x + 2 ) ) );
+            sum = _mm256_add_epi16( sum, _mm256_mullo_epi16( corners, _mm256_set1_epi16( C ) ) );
+        }
+
+        sum = _mm256_srli_epi16( sum, 4 );
+
+        __m128i result = _mm_packus_epi16( _mm256_castsi256_si128( sum ), _mm256_extracti128_si256( sum, 1 ) );
+        _mm_storeu_si128( reinterpret_cast<__m128i*>( dest + x ), _mm_or_si128( result, alpha ) );
+    }
+
+    return x;
+}
+
+template int antiAliasRowAVX2<16, 0, 0>( QRgb* dest, QRgb* rows[ 3 ], int width );
+template int antiAliasRowAVX2<12, 1, 0>( QRgb* dest, QRgb* rows[ 3 ], int width );
+template int antiAliasRowAVX2<8, 1, 1>( QRgb* dest, QRgb* rows[ 3 ], int width );
+template int antiAliasRowAVX2<4, 2, 1>( QRgb* dest, QRgb* rows[ 3 ], int width );
+
+} // namespace DataFunctions
+
+#endif // defined( HAVE_AVX2 )
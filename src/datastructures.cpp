@@ -108,30 +108,51 @@ QDataStream& operator <<( QDataStream& stream, const ColorMapping& mapping )
         << mapping.m_mirrored
         << mapping.m_reversed
         << mapping.m_scale
-        << mapping.m_offset;
+        << mapping.m_offset
+        << (qint8)mapping.m_transform;
 }
 
 QDataStream& operator >>( QDataStream& stream, ColorMapping& mapping )
 {
-    return stream
-        >> mapping.m_mirrored
+    int version = fraqtive()->configuration()->dataVersion();
+
+    stream >> mapping.m_mirrored
         >> mapping.m_reversed
         >> mapping.m_scale
         >> mapping.m_offset;
+
+    if ( version >= 4 ) {
+        qint8 transform;
+        stream >> transform;
+        mapping.m_transform = (ValueTransform)transform;
+    } else {
+        mapping.m_transform = SquareRootTransform;
+    }
+
+    return stream;
 }
 
 QDataStream& operator <<( QDataStream& stream, const GeneratorSettings& settings )
 {
     return stream
         << settings.m_calculationDepth
-        << settings.m_detailThreshold;
+        << settings.m_detailThreshold
+        << settings.m_automaticDepth;
 }
 
 QDataStream& operator >>( QDataStream& stream, GeneratorSettings& settings )
 {
-    return stream
-        >> settings.m_calculationDepth
+    int version = fraqtive()->configuration()->dataVersion();
+
+    stream >> settings.m_calculationDepth
         >> settings.m_detailThreshold;
+
+    if ( version >= 3 )
+        stream >> settings.m_automaticDepth;
+    else
+        settings.m_automaticDepth = false;
+
+    return stream;
 }
 
 QDataStream& operator <<( QDataStream& stream, const ViewSettings& settings )
@@ -190,6 +190,13 @@ inline bool operator ==( const Gradient& lhv, const Gradient& rhv )
 
 Q_DECLARE_METATYPE( Gradient )
 
+enum ValueTransform
+{
+    SquareRootTransform,
+    LinearTransform,
+    LogarithmicTransform
+};
+
 class ColorMapping
 {
 public:
@@ -208,6 +215,9 @@ public:
     void setOffset( double offset ) { m_offset = offset; }
     double offset() const { return m_offset; }
 
+    void setTransform( ValueTransform transform ) { m_transform = transform; }
+    ValueTransform transform() const { return m_transform; }
+
 public:
     friend QDataStream& operator <<( QDataStream& stream, const ColorMapping& mapping );
     friend QDataStream& operator >>( QDataStream& stream, ColorMapping& mapping );
@@ -220,13 +230,15 @@ private:
     bool m_reversed;
     double m_scale;
     double m_offset;
+    ValueTransform m_transform;
 };
 
 inline ColorMapping::ColorMapping() :
     m_mirrored( false ),
     m_reversed( false ),
     m_scale( 0.0 ),
-    m_offset( 0.0 )
+    m_offset( 0.0 ),
+    m_transform( SquareRootTransform )
 {
 }
 
@@ -235,7 +247,8 @@ inline bool operator ==( const ColorMapping& lhv, const ColorMapping& rhv )
     return ( lhv.m_mirrored == rhv.m_mirrored )
         && ( lhv.m_reversed == rhv.m_reversed )
         && qFuzzyCompare( lhv.m_scale, rhv.m_scale )
-        && qFuzzyCompare( lhv.m_offset, rhv.m_offset );
+        && qFuzzyCompare( lhv.m_offset, rhv.m_offset )
+        && ( lhv.m_transform == rhv.m_transform );
 }
 
 Q_DECLARE_METATYPE( ColorMapping )
@@ -252,6 +265,9 @@ public:
     void setDetailThreshold( double threshold ) { m_detailThreshold = threshold; }
     double detailThreshold() const { return m_detailThreshold; }
 
+    void setAutomaticDepth( bool automatic ) { m_automaticDepth = automatic; }
+    bool automaticDepth() const { return m_automaticDepth; }
+
 public:
     friend QDataStream& operator <<( QDataStream& stream, const GeneratorSettings& settings );
     friend QDataStream& operator >>( QDataStream& stream, GeneratorSettings& settings );
@@ -262,18 +278,21 @@ public:
 private:
     double m_calculationDepth;
     double m_detailThreshold;
+    bool m_automaticDepth;
 };
 
 inline GeneratorSettings::GeneratorSettings() :
     m_calculationDepth( 0.0 ),
-    m_detailThreshold( 0.0 )
+    m_detailThreshold( 0.0 ),
+    m_automaticDepth( false )
 {
 }
 
 inline bool operator ==( const GeneratorSettings& lhv, const GeneratorSettings& rhv )
 {
     return qFuzzyCompare( lhv.m_calculationDepth, rhv.m_calculationDepth )
-        && qFuzzyCompare( lhv.m_detailThreshold, rhv.m_detailThreshold );
+        && qFuzzyCompare( lhv.m_detailThreshold, rhv.m_detailThreshold )
+        && lhv.m_automaticDepth == rhv.m_automaticDepth;
 }
 
 Q_DECLARE_METATYPE( GeneratorSettings )
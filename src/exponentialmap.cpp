@@ -0,0 +1,444 @@
+/**************************************************************************
+* This file is part of the Fraqtive program
+* Copyright (C) 2004-2012 Michał Męciński
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**************************************************************************/
+
+#include "exponentialmap.h"
+
+#include <math.h>
+
+#ifndef M_PI
+# define M_PI 3.14159265358979323846
+#endif
+
+#include "fraqtiveapplication.h"
+#include "jobscheduler.h"
+#include "datafunctions.h"
+
+class PointCalculator
+{
+public:
+    PointCalculator( const FractalType& type ) :
+        m_functor( NULL )
+    {
+#if defined( HAVE_SSE2 )
+        m_functorSSE2 = DataFunctions::createFunctorSSE2( type );
+        if ( !m_functorSSE2 )
+#endif
+            m_functor = DataFunctions::createFunctor( type );
+    }
+
+    ~PointCalculator()
+    {
+#if defined( HAVE_SSE2 )
+        delete m_functorSSE2;
+#endif
+        delete m_functor;
+    }
+
+public:
+    void calculate( const double* zx, const double* zy, double* result, int count, int maxIterations )
+    {
+#if defined( HAVE_SSE2 )
+        if ( m_functorSSE2 ) {
+            GeneratorCore::generatePointsSSE2( zx, zy, result, count, m_functorSSE2, maxIterations );
+            return;
+        }
+#endif
+        if ( m_functor )
+            GeneratorCore::generatePoints( zx, zy, result, count, m_functor, maxIterations );
+    }
+
+private:
+    GeneratorCore::Functor* m_functor;
+#if defined( HAVE_SSE2 )
+    GeneratorCore::FunctorSSE2* m_functorSSE2;
+#endif
+};
+
+ExponentialMap::ExponentialMap( QObject* parent ) : QObject( parent ),
+    m_multiSampling( 0 ),
+    m_zoomFrom( 0.0 ),
+    m_zoomTo( 0.0 ),
+    m_angles( 0 ),
+    m_rows( 0 ),
+    m_step( 0.0 ),
+    m_innerRadius( 0.0 ),
+    m_logInnerRadius( 0.0 ),
+    m_bandCount( 0 ),
+    m_bits( NULL ),
+    m_bytesPerLine( 0 ),
+    m_nextBand( 0 ),
+    m_finishedBands( 0 ),
+    m_activeJobs( 0 )
+{
+}
+
+ExponentialMap::~ExponentialMap()
+{
+    abort();
+}
+
+void ExponentialMap::setResolution( const QSize& resolution, int multiSampling )
+{
+    m_resolution = resolution;
+    m_multiSampling = multiSampling;
+}
+
+void ExponentialMap::setParameters( const FractalType& type, const Position& position )
+{
+    m_type = type;
+    m_position = position;
+}
+
+void ExponentialMap::setZoomRange( double zoomFrom, double zoomTo )
+{
+    m_zoomFrom = zoomFrom;
+    m_zoomTo = zoomTo;
+}
+
+void ExponentialMap::setColorSettings( const Gradient& gradient, const QColor& backgroundColor, const ColorMapping& mapping )
+{
+    m_gradientCache = DataFunctions::sharedGradientCache( gradient, DataFunctions::GradientSize );
+
+    m_backgroundColor = backgroundColor;
+    m_colorMapping = mapping;
+}
+
+void ExponentialMap::setGeneratorSettings( const GeneratorSettings& settings )
+{
+    m_generatorSettings = settings;
+}
+
+static const int BandRows = 16;
+static const double InnerRadius = 16.0;
+static const qint64 MaximumStripSize = 512 * 1024 * 1024;
+
+void ExponentialMap::calculateLayout()
+{
+    int factor = 1 << m_multiSampling;
+
+    double width = (double)( m_resolution.width() * factor );
+    double height = (double)( m_resolution.height() * factor );
+    double diagonal = sqrt( width * width + height * height );
+
+    // the distance between samples on the outer circle of every image is at most one sample
+    m_angles = (int)ceil( M_PI * diagonal );
+    m_step = 2.0 * M_PI / (double)m_angles;
+
+    // size of a single sample in the most and the least zoomed image
+    double minScale = pow( 10.0, -qMax( m_zoomFrom, m_zoomTo ) ) / height;
+    double maxScale = pow( 10.0, -qMin( m_zoomFrom, m_zoomTo ) ) / height;
+
+    // the center of the most zoomed images is not covered by the strip
+    m_innerRadius = InnerRadius * factor * minScale;
+    m_logInnerRadius = log( m_innerRadius );
+
+    double outerRadius = maxScale * diagonal / 2.0;
+
+    m_rows = (int)ceil( ( log( outerRadius ) - m_logInnerRadius ) / m_step ) + 2;
+    m_bandCount = ( m_rows + BandRows - 1 ) / BandRows;
+}
+
+bool ExponentialMap::isEfficient( int images )
+{
+    calculateLayout();
+
+    qint64 stripPoints = (qint64)m_angles * m_rows;
+    qint64 imagePoints = (qint64)m_resolution.width() * m_resolution.height() * images << ( 2 * m_multiSampling );
+
+    // short zooms share too little of their content to make the strip worthwhile
+    return stripPoints * sizeof( QRgb ) <= MaximumStripSize && 2 * stripPoints < imagePoints;
+}
+
+bool ExponentialMap::start()
+{
+    calculateLayout();
+
+    m_strip = QImage( m_angles, m_rows, QImage::Format_RGB32 );
+
+    if ( m_strip.isNull() )
+        return false;
+
+    // rows of the strip are written by the jobs without detaching the image
+    m_bits = m_strip.bits();
+    m_bytesPerLine = m_strip.bytesPerLine();
+
+    m_nextBand = 0;
+    m_finishedBands = 0;
+
+    addJobs( m_bandCount );
+
+    return true;
+}
+
+void ExponentialMap::abort()
+{
+    QMutexLocker locker( &m_mutex );
+
+    m_nextBand = m_bandCount;
+
+    m_pendingIndexes.clear();
+    m_pendingPositions.clear();
+
+    cancelJobs();
+
+    while ( m_activeJobs > 0 )
+        m_allJobsDone.wait( &m_mutex );
+}
+
+void ExponentialMap::addImage( int index, const Position& position )
+{
+    QMutexLocker locker( &m_mutex );
+
+    m_pendingIndexes.append( index );
+    m_pendingPositions.append( position );
+
+    addJobs( 1 );
+}
+
+int ExponentialMap::priority() const
+{
+    return 1;
+}
+
+void ExponentialMap::executeJob()
+{
+    QMutexLocker locker( &m_mutex );
+
+    if ( m_nextBand < m_bandCount )
+        calculateBand( m_nextBand++ );
+    else if ( !m_pendingIndexes.isEmpty() )
+        calculateImage( m_pendingIndexes.takeFirst(), m_pendingPositions.takeFirst() );
+
+    finishJob();
+}
+
+void ExponentialMap::calculateBand( int band )
+{
+    int top = band * BandRows;
+    int bottom = qMin( top + BandRows, m_rows );
+
+    m_mutex.unlock();
+
+    PointCalculator calculator( m_type );
+
+    DataFunctions::ColorMapper mapper( m_gradientCache.constData(), m_gradientCache.count(), m_backgroundColor.rgb(), m_colorMapping );
+
+    QVector<double> zx( m_angles );
+    QVector<double> zy( m_angles );
+    QVector<double> values( m_angles );
+
+    for ( int y = top; y < bottom; y++ ) {
+        double radius = exp( m_logInnerRadius + (double)y * m_step );
+
+        for ( int x = 0; x < m_angles; x++ ) {
+            double angle = (double)x * m_step;
+            zx[ x ] = m_position.center().x() + radius * cos( angle );
+            zy[ x ] = m_position.center().y() + radius * sin( angle );
+        }
+
+        // each row needs as many iterations as an image whose height is twice the radius
+        calculator.calculate( zx.constData(), zy.constData(), values.data(), m_angles, maximumIterations( -log10( 2.0 * radius ) ) );
+
+        mapper.mapRow( reinterpret_cast<QRgb*>( m_bits + y * m_bytesPerLine ), values.constData(), m_angles );
+    }
+
+    m_mutex.lock();
+
+    m_finishedBands++;
+
+    emit progressChanged( m_finishedBands );
+
+    if ( m_finishedBands == m_bandCount )
+        emit completed();
+}
+
+void ExponentialMap::calculateImage( int index, const Position& position )
+{
+    m_mutex.unlock();
+
+    PointCalculator calculator( m_type );
+
+    DataFunctions::ColorMapper mapper( m_gradientCache.constData(), m_gradientCache.count(), m_backgroundColor.rgb(), m_colorMapping );
+
+    QImage image = renderImage( position, &calculator, mapper );
+
+    m_mutex.lock();
+
+    emit imageCompleted( index, image );
+}
+
+QImage ExponentialMap::renderImage( const Position& position, PointCalculator* calculator, const DataFunctions::ColorMapper& mapper ) const
+{
+    QImage image( m_resolution, QImage::Format_RGB32 );
+
+    if ( image.isNull() )
+        return image;
+
+    int factor = 1 << m_multiSampling;
+    int area = factor * factor;
+
+    int width = m_resolution.width();
+    int height = m_resolution.height();
+
+    double scale = pow( 10.0, -position.zoomFactor() ) / (double)( height * factor );
+
+    double sa = scale * sin( position.angle() * M_PI / 180.0 );
+    double ca = scale * cos( position.angle() * M_PI / 180.0 );
+
+    double innerRadius2 = m_innerRadius * m_innerRadius;
+
+    int maxIterations = maximumIterations( position.zoomFactor() );
+
+    QVector<int> sums( 3 * width );
+
+    QVector<double> zx;
+    QVector<double> zy;
+    QVector<double> values;
+    QVector<int> columns;
+
+    for ( int y = 0; y < height; y++ ) {
+        sums.fill( 0 );
+
+        zx.clear();
+        zy.clear();
+        columns.clear();
+
+        for ( int i = 0; i < factor; i++ ) {
+            double offsetY = (double)( y * factor + i ) + 0.5 - (double)( height * factor ) / 2.0;
+
+            for ( int x = 0; x < width; x++ ) {
+                for ( int j = 0; j < factor; j++ ) {
+                    double offsetX = (double)( x * factor + j ) + 0.5 - (double)( width * factor ) / 2.0;
+
+                    double px = ca * offsetX + sa * offsetY;
+                    double py = -sa * offsetX + ca * offsetY;
+
+                    double radius2 = px * px + py * py;
+
+                    // samples in the center are calculated directly
+                    if ( radius2 < innerRadius2 ) {
+                        zx.append( m_position.center().x() + px );
+                        zy.append( m_position.center().y() + py );
+                        columns.append( x );
+                        continue;
+                    }
+
+                    double u = ( 0.5 * log( radius2 ) - m_logInnerRadius ) / m_step;
+                    double t = atan2( py, px ) / m_step;
+                    if ( t < 0.0 )
+                        t += (double)m_angles;
+
+                    QRgb color = sampleStrip( u, t );
+
+                    int* sum = sums.data() + 3 * x;
+                    sum[ 0 ] += qRed( color );
+                    sum[ 1 ] += qGreen( color );
+                    sum[ 2 ] += qBlue( color );
+                }
+            }
+        }
+
+        if ( !columns.isEmpty() ) {
+            values.resize( columns.count() );
+
+            calculator->calculate( zx.constData(), zy.constData(), values.data(), columns.count(), maxIterations );
+
+            for ( int k = 0; k < columns.count(); k++ ) {
+                QRgb color = mapper.map( values.at( k ) );
+
+                int* sum = sums.data() + 3 * columns.at( k );
+                sum[ 0 ] += qRed( color );
+                sum[ 1 ] += qGreen( color );
+                sum[ 2 ] += qBlue( color );
+            }
+        }
+
+        QRgb* dest = reinterpret_cast<QRgb*>( image.scanLine( y ) );
+
+        for ( int x = 0; x < width; x++ ) {
+            const int* sum = sums.constData() + 3 * x;
+            dest[ x ] = qRgb( ( sum[ 0 ] + area / 2 ) / area, ( sum[ 1 ] + area / 2 ) / area, ( sum[ 2 ] + area / 2 ) / area );
+        }
+    }
+
+    return image;
+}
+
+static inline int lerp( int a, int b, double f )
+{
+    return a + (int)( (double)( b - a ) * f + 0.5 );
+}
+
+QRgb ExponentialMap::sampleStrip( double u, double t ) const
+{
+    u = qBound( 0.0, u, (double)( m_rows - 1 ) );
+
+    int y = qMin( (int)u, m_rows - 2 );
+    double fy = u - (double)y;
+
+    int x1 = (int)t;
+    double fx = t - (double)x1;
+
+    // the angle wraps around
+    x1 %= m_angles;
+    int x2 = ( x1 + 1 ) % m_angles;
+
+    const QRgb* row1 = reinterpret_cast<const QRgb*>( m_strip.scanLine( y ) );
+    const QRgb* row2 = reinterpret_cast<const QRgb*>( m_strip.scanLine( y + 1 ) );
+
+    QRgb c11 = row1[ x1 ];
+    QRgb c12 = row1[ x2 ];
+    QRgb c21 = row2[ x1 ];
+    QRgb c22 = row2[ x2 ];
+
+    int red = lerp( lerp( qRed( c11 ), qRed( c12 ), fx ), lerp( qRed( c21 ), qRed( c22 ), fx ), fy );
+    int green = lerp( lerp( qGreen( c11 ), qGreen( c12 ), fx ), lerp( qGreen( c21 ), qGreen( c22 ), fx ), fy );
+    int blue = lerp( lerp( qBlue( c11 ), qBlue( c12 ), fx ), lerp( qBlue( c21 ), qBlue( c22 ), fx ), fy );
+
+    return qRgb( red, green, blue );
+}
+
+int ExponentialMap::maximumIterations( double zoomFactor ) const
+{
+    return (int)( pow( 10.0, m_generatorSettings.calculationDepth() ) * qMax( 1.0, 1.45 + zoomFactor ) );
+}
+
+void ExponentialMap::addJobs( int count )
+{
+    if ( count > 0 ) {
+        fraqtive()->jobScheduler()->addJobs( this, count );
+        m_activeJobs += count;
+    }
+}
+
+void ExponentialMap::cancelJobs()
+{
+    int count = fraqtive()->jobScheduler()->cancelAllJobs( this );
+    m_activeJobs -= count;
+
+    if ( m_activeJobs == 0 )
+        m_allJobsDone.wakeAll();
+}
+
+void ExponentialMap::finishJob()
+{
+    m_activeJobs--;
+
+    if ( m_activeJobs == 0 )
+        m_allJobsDone.wakeAll();
+}
@@ -0,0 +1,130 @@
+/**************************************************************************
+* This file is part of the Fraqtive program
+* Copyright (C) 2004-2012 Michał Męciński
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**************************************************************************/
+
+#ifndef EXPONENTIALMAP_H
+#define EXPONENTIALMAP_H
+
+#include <QObject>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QImage>
+#include <QVector>
+
+#include "abstractjobprovider.h"
+#include "datastructures.h"
+
+class PointCalculator;
+
+namespace DataFunctions
+{
+class ColorMapper;
+}
+
+// calculates a log-polar strip around the center of a zoom series
+// and renders the images of the series by resampling the strip
+class ExponentialMap : public QObject, public AbstractJobProvider
+{
+    Q_OBJECT
+public:
+    ExponentialMap( QObject* parent );
+    ~ExponentialMap();
+
+public:
+    void setResolution( const QSize& resolution, int multiSampling );
+    void setParameters( const FractalType& type, const Position& position );
+    void setZoomRange( double zoomFrom, double zoomTo );
+    void setColorSettings( const Gradient& gradient, const QColor& backgroundColor, const ColorMapping& mapping );
+    void setGeneratorSettings( const GeneratorSettings& settings );
+
+    bool isEfficient( int images );
+
+    int maximumProgress() const { return m_bandCount; }
+
+    bool start();
+    void abort();
+
+    void addImage( int index, const Position& position );
+
+public: // AbstractJobProvider implementation
+    int priority() const;
+
+    void executeJob();
+
+signals:
+    void progressChanged( int value );
+    void completed();
+    void imageCompleted( int index, const QImage& image );
+
+private:
+    void calculateLayout();
+
+    void calculateBand( int band );
+    void calculateImage( int index, const Position& position );
+
+    QImage renderImage( const Position& position, PointCalculator* calculator, const DataFunctions::ColorMapper& mapper ) const;
+
+    QRgb sampleStrip( double u, double t ) const;
+
+    int maximumIterations( double zoomFactor ) const;
+
+    void addJobs( int count );
+    void cancelJobs();
+    void finishJob();
+
+private:
+    QSize m_resolution;
+    int m_multiSampling;
+
+    FractalType m_type;
+    Position m_position;
+
+    double m_zoomFrom;
+    double m_zoomTo;
+
+    QVector<QRgb> m_gradientCache;
+    QColor m_backgroundColor;
+    ColorMapping m_colorMapping;
+
+    GeneratorSettings m_generatorSettings;
+
+    int m_angles;
+    int m_rows;
+    double m_step;
+
+    double m_innerRadius;
+    double m_logInnerRadius;
+
+    int m_bandCount;
+
+    QMutex m_mutex;
+
+    QImage m_strip;
+    uchar* m_bits;
+    int m_bytesPerLine;
+
+    int m_nextBand;
+    int m_finishedBands;
+
+    QList<int> m_pendingIndexes;
+    QList<Position> m_pendingPositions;
+
+    int m_activeJobs;
+    QWaitCondition m_allJobsDone;
+};
+
+#endif
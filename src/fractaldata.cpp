@@ -18,10 +18,15 @@
 
 #include "fractaldata.h"
 
+#include <string.h>
+
 FractalData::FractalData() :
     m_buffer( NULL ),
     m_owner( false ),
-    m_stride( 0 )
+    m_stride( 0 ),
+    m_colored( false ),
+    m_copiedRows( 0 ),
+    m_colorSerial( 0 )
 {
 }
 
@@ -41,6 +46,7 @@ void FractalData::clear()
     m_stride = 0;
     m_size = QSize();
     m_validRegions.clear();
+    clearColoredImage();
 }
 
 void FractalData::setBuffer( double* buffer, int stride, const QSize& size )
@@ -53,6 +59,7 @@ void FractalData::setBuffer( double* buffer, int stride, const QSize& size )
     m_stride = stride;
     m_size = size;
     m_validRegions.clear();
+    clearColoredImage();
 }
 
 void FractalData::transferBuffer( double* buffer, int stride, const QSize& size )
@@ -65,6 +72,7 @@ void FractalData::transferBuffer( double* buffer, int stride, const QSize& size
     m_stride = stride;
     m_size = size;
     m_validRegions.clear();
+    clearColoredImage();
 }
 
 void FractalData::setValidRegion( const QRect& region )
@@ -77,3 +85,40 @@ void FractalData::setValidRegions( const QList<QRect>& regions )
 {
     m_validRegions = regions;
 }
+
+void FractalData::setColoredImage( const QImage& image, const QImage& indexImage, const QList<QRect>& regions, int serial )
+{
+    // the generator's image is modified by its jobs, so the rows are copied while it's locked;
+    // only the rows which were colored since the previous update are copied
+    if ( !m_colored || serial != m_colorSerial || m_image.size() != image.size() ) {
+        if ( m_image.size() != image.size() ) {
+            m_image = QImage( image.size(), QImage::Format_RGB32 );
+            m_indexImage = QImage( image.size(), QImage::Format_Indexed8 );
+        }
+        m_colored = true;
+        m_copiedRows = 0;
+    }
+
+    if ( regions.count() > 0 && regions.first().top() == 0 ) {
+        int bottom = qMin( regions.first().bottom() + 1, m_image.height() );
+        int bytes = m_image.width() * sizeof( QRgb );
+
+        for ( int y = m_copiedRows; y < bottom; y++ ) {
+            memcpy( m_image.scanLine( y ), image.scanLine( y ), bytes );
+            memcpy( m_indexImage.scanLine( y ), indexImage.scanLine( y ), m_image.width() );
+        }
+
+        m_copiedRows = qMax( m_copiedRows, bottom );
+    }
+
+    m_coloredRegions = regions;
+    m_colorSerial = serial;
+}
+
+void FractalData::clearColoredImage()
+{
+    m_colored = false;
+    m_copiedRows = 0;
+    m_coloredRegions.clear();
+    m_colorSerial = 0;
+}
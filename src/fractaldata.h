@@ -19,6 +19,8 @@
 #ifndef FRACTALDATA_H
 #define FRACTALDATA_H
 
+#include <QImage>
+
 #include "datastructures.h"
 
 class FractalData
@@ -42,6 +44,15 @@ public:
 
     QList<QRect> validRegions() const { return m_validRegions; }
 
+    void setColoredImage( const QImage& image, const QImage& indexImage, const QList<QRect>& regions, int serial );
+    void clearColoredImage();
+
+    const QImage* image() const { return m_colored ? &m_image : NULL; }
+    const QImage* indexImage() const { return m_colored ? &m_indexImage : NULL; }
+
+    QList<QRect> coloredRegions() const { return m_coloredRegions; }
+    int colorSerial() const { return m_colorSerial; }
+
 private:
     double* m_buffer;
     bool m_owner;
@@ -50,6 +61,13 @@ private:
     QSize m_size;
 
     QList<QRect> m_validRegions;
+
+    QImage m_image;
+    QImage m_indexImage;
+    bool m_colored;
+    int m_copiedRows;
+    QList<QRect> m_coloredRegions;
+    int m_colorSerial;
 };
 
 #endif
@@ -19,6 +19,7 @@
 #include "fractalgenerator.h"
 
 #include <math.h>
+#include <string.h>
 
 #ifndef M_PI
 # define M_PI 3.14159265358979323846
@@ -34,15 +35,36 @@ FractalGenerator::FractalGenerator( QObject* parent ) : QObject( parent ),
     m_priority( 0 ),
     m_receiver( NULL ),
     m_enabled( false ),
+    m_interactive( false ),
+    m_coarse( false ),
+    m_refining( false ),
+    m_detailing( false ),
+    m_continuous( false ),
+    m_remapping( false ),
+    m_remapped( false ),
+    m_progressive( false ),
+    m_deepening( false ),
+    m_iterations( 0 ),
+    m_probing( false ),
+    m_estimatedIterations( 0 ),
     m_functor( NULL ),
 #if defined( HAVE_SSE2 )
     m_functorSSE2( NULL ),
 #endif
     m_buffer( NULL ),
+    m_pointFlags( NULL ),
+    m_remapBuffer( NULL ),
+    m_remapStride( 0 ),
+    m_mirrorRow( -1 ),
     m_activeJobs( 0 ),
     m_pending( false ),
     m_update( NoUpdate ),
-    m_previewBuffer( NULL )
+    m_previewBuffer( NULL ),
+    m_colorizing( false ),
+    m_antiAliasing( NoAntiAliasing ),
+    m_colorSerial( 0 ),
+    m_indexBuffer( NULL ),
+    m_indexSerial( 0 )
 {
 }
 
@@ -62,7 +84,10 @@ FractalGenerator::~FractalGenerator()
 #endif
 
     delete[] m_buffer;
+    delete[] m_pointFlags;
+    delete[] m_remapBuffer;
     delete[] m_previewBuffer;
+    delete[] m_indexBuffer;
 }
 
 void FractalGenerator::setPreviewMode( bool preview )
@@ -94,6 +119,45 @@ void FractalGenerator::setEnabled( bool enabled )
     }
 }
 
+void FractalGenerator::setInteractive( bool interactive )
+{
+    QMutexLocker locker( &m_mutex );
+
+    if ( interactive != m_interactive ) {
+        m_interactive = interactive;
+
+        if ( !interactive )
+            handleState();
+    }
+}
+
+void FractalGenerator::setContinuous( bool continuous )
+{
+    QMutexLocker locker( &m_mutex );
+
+    if ( continuous != m_continuous ) {
+        m_continuous = continuous;
+
+        if ( !continuous )
+            handleState();
+    }
+}
+
+void FractalGenerator::setProgressiveDepth( bool progressive )
+{
+    QMutexLocker locker( &m_mutex );
+
+    if ( progressive != m_progressive ) {
+        m_progressive = progressive;
+        m_pending = true;
+
+        if ( !m_preview )
+            reset();
+
+        handleState();
+    }
+}
+
 void FractalGenerator::setParameters( const FractalType& type, const Position& position )
 {
     QMutexLocker locker( &m_mutex );
@@ -141,12 +205,96 @@ void FractalGenerator::setGeneratorSettings( const GeneratorSettings& settings )
     m_pendingSettings = settings;
     m_pending = true;
 
-    if ( !m_preview )
-        reset();
+    // when only the depth is increased the current frame is deepened
+    // and when only the threshold is changed the preview grid is reused
+    if ( !m_preview && !canDeepen() ) {
+        if ( canRedetail() )
+            cancelJobs();
+        else
+            reset();
+    }
 
     handleState();
 }
 
+void FractalGenerator::setColorizing( bool colorizing )
+{
+    QMutexLocker locker( &m_mutex );
+
+    if ( colorizing != m_colorizing ) {
+        m_colorizing = colorizing;
+
+        if ( colorizing && m_buffer && m_image.size() != m_resolution - QSize( 2, 2 ) ) {
+            m_image = QImage( m_resolution - QSize( 2, 2 ), QImage::Format_RGB32 );
+            m_indexImage = QImage( m_resolution - QSize( 2, 2 ), QImage::Format_Indexed8 );
+        }
+
+        if ( colorizing && m_buffer && !m_indexBuffer )
+            m_indexBuffer = new int[ m_bufferSize.width() * m_bufferSize.height() ];
+
+        recolorImage();
+    }
+}
+
+void FractalGenerator::setColorSettings( const Gradient& gradient, const QColor& backgroundColor, const ColorMapping& mapping )
+{
+    QVector<QRgb> cache = DataFunctions::sharedGradientCache( gradient, DataFunctions::GradientSize );
+
+    QMutexLocker locker( &m_mutex );
+
+    // jobs which are still using the previous cache hold a reference to it
+    m_gradientCache = cache;
+    m_backgroundColor = backgroundColor;
+    m_colorMapping = mapping;
+
+    invalidateIndexes();
+    recolorImage();
+}
+
+void FractalGenerator::setGradient( const Gradient& gradient )
+{
+    QVector<QRgb> cache = DataFunctions::sharedGradientCache( gradient, DataFunctions::GradientSize );
+
+    QMutexLocker locker( &m_mutex );
+
+    m_gradientCache = cache;
+
+    recolorImage();
+}
+
+void FractalGenerator::setBackgroundColor( const QColor& color )
+{
+    QMutexLocker locker( &m_mutex );
+
+    m_backgroundColor = color;
+
+    recolorImage();
+}
+
+void FractalGenerator::setColorMapping( const ColorMapping& mapping )
+{
+    QMutexLocker locker( &m_mutex );
+
+    m_colorMapping = mapping;
+
+    invalidateIndexes();
+    recolorImage();
+}
+
+void FractalGenerator::setViewSettings( const ViewSettings& settings )
+{
+    QMutexLocker locker( &m_mutex );
+
+    if ( settings.antiAliasing() != m_antiAliasing ) {
+        m_antiAliasing = settings.antiAliasing();
+
+        recolorImage();
+    }
+}
+
+static const int MinimumIterations = 256;
+static const int DeepeningFactor = 4;
+
 static const int CellsPerRegion = 8;
 static const int RegionSize = CellsPerRegion * GeneratorCore::CellSize + 1;
 
@@ -172,16 +320,29 @@ void FractalGenerator::setResolution( const QSize& resolution )
     m_pendingBufferSize = QSize( width, height );
     m_pending = true;
 
-    reset();
+    if ( canResize() )
+        cancelJobs();
+    else
+        reset();
 
     handleState();
 }
 
 int FractalGenerator::maximumIterations() const
 {
+    if ( m_settings.automaticDepth() && m_estimatedIterations > 0 )
+        return m_estimatedIterations;
+
     return (int)( pow( 10.0, m_settings.calculationDepth() ) * qMax( 1.0, 1.45 + m_position.zoomFactor() ) );
 }
 
+QVector<int> FractalGenerator::escapeHistogram()
+{
+    QMutexLocker locker( &m_mutex );
+
+    return m_histogram;
+}
+
 FractalGenerator::UpdateStatus FractalGenerator::updateData( FractalData* data )
 {
     QMutexLocker locker( &m_mutex );
@@ -215,6 +376,13 @@ FractalGenerator::UpdateStatus FractalGenerator::updateData( FractalData* data )
             break;
     }
 
+    if ( update != FullUpdate && update != ClearUpdate && !data->isEmpty() ) {
+        if ( isColorizing() )
+            data->setColoredImage( m_image, m_indexImage, m_coloredRegions, m_colorSerial );
+        else
+            data->clearColoredImage();
+    }
+
     return update;
 }
 
@@ -227,13 +395,82 @@ void FractalGenerator::executeJob()
 {
     QMutexLocker locker( &m_mutex );
 
-    if ( m_enabled && m_regions.count() > 0 )
-        calculateRegion( m_regions.takeFirst() );
+    if ( m_enabled && m_probing )
+        probeIterations();
+    else if ( m_enabled && m_colorRegions.count() > 0 )
+        colorizeRegion( m_colorRegions.takeFirst() );
+    else if ( m_enabled && m_regions.count() > 0 ) {
+        QRect region = m_regions.takeFirst();
+        if ( m_mirrorRegions.contains( region ) )
+            mirrorRegion( region );
+        else
+            calculateRegion( region );
+    }
 
     finishJob();
     handleState();
 }
 
+static void appendRegion( QList<QRect>& regions, const QRect& region )
+{
+    QRect united = region;
+
+    // merge with all overlapping and adjacent regions
+    int i = 0;
+    while ( i < regions.count() ) {
+        const QRect& current = regions.at( i );
+        if ( current.bottom() + 1 < united.top() ) {
+            i++;
+            continue;
+        }
+        if ( current.top() > united.bottom() + 1 )
+            break;
+        united = united.united( current );
+        regions.removeAt( i );
+    }
+
+    regions.insert( i, united );
+}
+
+static bool containsRegion( const QList<QRect>& regions, const QRect& region )
+{
+    for ( int i = 0; i < regions.count(); i++ ) {
+        if ( regions.at( i ).top() <= region.top() && regions.at( i ).bottom() >= region.bottom() )
+            return true;
+    }
+    return false;
+}
+
+void FractalGenerator::probeIterations()
+{
+    FractalType type = m_type;
+    Position position = m_position;
+    QSize resolution = m_resolution;
+
+    m_estimatedIterations = 0;
+
+    int iterations = maximumIterations();
+
+    m_mutex.unlock();
+
+    QVector<int> histogram;
+    iterations = DataFunctions::estimateIterations( type, position, resolution, iterations, &histogram );
+
+    m_mutex.lock();
+
+    // the frame is calculated again if anything was changed in the meantime
+    if ( m_pending )
+        return;
+
+    m_estimatedIterations = iterations;
+    m_histogram = histogram;
+
+    m_iterations = initialIterations( false );
+    m_probing = false;
+
+    splitRegions();
+}
+
 void FractalGenerator::calculateRegion( const QRect& region )
 {
     GeneratorCore::Input input;
@@ -242,30 +479,373 @@ void FractalGenerator::calculateRegion( const QRect& region )
     GeneratorCore::Output output;
     calculateOutput( &output, region );
 
-    int maxIterations = maximumIterations();
+    int maxIterations = m_iterations;
     double threshold = m_settings.detailThreshold();
 
+    // the refining pass reuses the preview grid calculated by the coarse pass
+    // and the detailing pass interpolates it again before calculating details;
+    // the deepening pass only calculates the details which appear after
+    // resuming the points which haven't escaped yet
+    bool preview = !m_refining && !m_detailing && !m_deepening;
+    bool interpolation = preview || m_detailing || m_deepening;
+    bool details = !m_coarse;
+
+    bool remap = m_remapping;
+
+    unsigned char* flags = m_pointFlags ? m_pointFlags + region.top() * m_bufferSize.width() : NULL;
+    QVector<GeneratorCore::Sample>* samples = m_pointFlags ? m_samples.data() + region.top() / RegionSize : NULL;
+    bool deepening = m_deepening;
+
     m_mutex.unlock();
 
+    // a new frame is calculated from scratch; remapped points are not resumable
+    if ( flags && ( remap || preview ) ) {
+        memset( flags, 0, output.m_stride * output.m_height );
+        samples->clear();
+    }
+
+    if ( remap ) {
+        remapRegion( input, region, maxIterations );
+    } else {
+        // calculated points which haven't escaped continue from where the previous pass stopped
+        if ( deepening && m_functor )
+            GeneratorCore::resumeSamples( input, output, flags, samples, m_functor, maxIterations );
+
+        // distances of the grid points are not stored, so they are only
+        // available when both passes are calculated at once
+        double* distances = ( preview && details ) ? new double[ output.m_stride * output.m_height ] : NULL;
+
 #if defined( HAVE_SSE2 )
-    if ( m_functorSSE2 ) {
-        GeneratorCore::generatePreviewSSE2( input, output, m_functorSSE2, maxIterations );
-        GeneratorCore::interpolate( output );
-        GeneratorCore::generateDetailsSSE2( input, output, m_functorSSE2, maxIterations, threshold );
-    } else
+        if ( m_functorSSE2 ) {
+            if ( preview )
+                GeneratorCore::generatePreviewSSE2( input, output, m_functorSSE2, maxIterations, distances );
+            if ( interpolation )
+                GeneratorCore::interpolate( output, flags );
+            if ( details )
+                GeneratorCore::generateDetailsSSE2( input, output, m_functorSSE2, maxIterations, threshold, distances, flags );
+        } else
 #endif
-    if ( m_functor ) {
-        GeneratorCore::generatePreview( input, output, m_functor, maxIterations );
-        GeneratorCore::interpolate( output );
-        GeneratorCore::generateDetails( input, output, m_functor, maxIterations, threshold );
+        if ( m_functor ) {
+            if ( preview )
+                GeneratorCore::generatePreview( input, output, m_functor, maxIterations, distances );
+            if ( interpolation )
+                GeneratorCore::interpolate( output, flags );
+            if ( details )
+                GeneratorCore::generateDetails( input, output, m_functor, maxIterations, threshold, distances, flags );
+        }
+
+        delete[] distances;
     }
 
     m_mutex.lock();
 
+    appendRegion( m_calculatedRegions, region );
     appendValidRegion( region );
 
-    if ( !m_preview && m_update == NoUpdate )
+    if ( isColorizing() )
+        colorizeRegion( colorableRegion( region ) );
+    else if ( !m_preview && m_update == NoUpdate )
         postUpdate( PartialUpdate );
+
+    // copy the mirrored regions which were waiting for this one
+    int i = 0;
+    while ( i < m_deferredRegions.count() ) {
+        if ( containsRegion( m_calculatedRegions, mirroredRegion( m_deferredRegions.at( i ) ) ) ) {
+            mirrorRegion( m_deferredRegions.takeAt( i ) );
+            i = 0;
+        } else {
+            i++;
+        }
+    }
+}
+
+void FractalGenerator::mirrorRegion( const QRect& region )
+{
+    // the job which calculates the last symmetric row copies this region later
+    if ( !containsRegion( m_calculatedRegions, mirroredRegion( region ) ) ) {
+        m_deferredRegions.append( region );
+        return;
+    }
+
+    GeneratorCore::Input input;
+    calculateInput( &input, region );
+
+    int stride = m_bufferSize.width();
+    int mirrorRow = m_mirrorRow;
+    QVector<int> columns = m_mirrorColumns;
+    QVector<int> missingColumns = m_missingColumns;
+
+    int maxIterations = m_iterations;
+
+    m_mutex.unlock();
+
+    for ( int y = 0; y < region.height(); y++ ) {
+        double* row = m_buffer + ( region.top() + y ) * stride;
+        const double* source = m_buffer + ( mirrorRow - region.top() - y ) * stride;
+
+        if ( columns.isEmpty() ) {
+            memcpy( row, source, stride * sizeof( double ) );
+            continue;
+        }
+
+        for ( int x = 0; x < stride; x++ ) {
+            int column = columns.at( x );
+            if ( column >= 0 )
+                row[ x ] = source[ column ];
+        }
+
+        calculatePoints( input, row, y, missingColumns.constData(), missingColumns.count(), maxIterations );
+    }
+
+    m_mutex.lock();
+
+    appendValidRegion( region );
+
+    if ( isColorizing() )
+        colorizeRegion( colorableRegion( region ) );
+    else if ( !m_preview && m_update == NoUpdate )
+        postUpdate( PartialUpdate );
+}
+
+void FractalGenerator::remapRegion( const GeneratorCore::Input& input, const QRect& region, int maxIterations )
+{
+    int stride = m_bufferSize.width();
+    int width = region.width();
+
+    // the positions are calculated together with the maps, for remapped and resized frames
+    Q_ASSERT( m_columnPositions.count() == stride && m_rowPositions.count() == m_bufferSize.height() );
+
+    QVector<int> allColumns( width );
+    QVector<int> missingColumns;
+
+    for ( int x = 0; x < width; x++ ) {
+        allColumns[ x ] = x;
+        if ( m_columnMap.at( x ) < 0 )
+            missingColumns.append( x );
+    }
+
+    for ( int y = 0; y < region.height(); y++ ) {
+        double* row = m_buffer + ( region.top() + y ) * stride;
+
+        // new points are calculated at the positions of the reused samples
+        double position = m_rowPositions.at( region.top() + y ) - region.top();
+
+        int oldRow = m_rowMap.at( region.top() + y );
+        if ( oldRow < 0 ) {
+            remapPoints( input, row, position, allColumns.constData(), width, maxIterations );
+            continue;
+        }
+
+        const double* oldValues = m_remapBuffer + oldRow * m_remapStride;
+        for ( int x = 0; x < width; x++ ) {
+            int oldColumn = m_columnMap.at( x );
+            if ( oldColumn >= 0 )
+                row[ x ] = oldValues[ oldColumn ];
+        }
+
+        remapPoints( input, row, position, missingColumns.constData(), missingColumns.count(), maxIterations );
+    }
+}
+
+void FractalGenerator::remapPoints( const GeneratorCore::Input& input, double* row, double y, const int* columns, int count, int maxIterations )
+{
+    if ( count == 0 )
+        return;
+
+    QVector<double> zx( count );
+    QVector<double> zy( count );
+    QVector<double> result( count );
+
+    for ( int i = 0; i < count; i++ ) {
+        double x = m_columnPositions.at( columns[ i ] );
+        zx[ i ] = input.m_x + input.m_ca * x + input.m_sa * y;
+        zy[ i ] = input.m_y - input.m_sa * x + input.m_ca * y;
+    }
+
+    bool calculated = false;
+
+#if defined( HAVE_SSE2 )
+    if ( m_functorSSE2 ) {
+        GeneratorCore::generatePointsSSE2( zx.constData(), zy.constData(), result.data(), count, m_functorSSE2, maxIterations );
+        calculated = true;
+    }
+#endif
+
+    if ( !calculated && m_functor ) {
+        GeneratorCore::generatePoints( zx.constData(), zy.constData(), result.data(), count, m_functor, maxIterations );
+        calculated = true;
+    }
+
+    if ( !calculated )
+        return;
+
+    for ( int i = 0; i < count; i++ )
+        row[ columns[ i ] ] = result[ i ];
+}
+
+void FractalGenerator::calculatePoints( const GeneratorCore::Input& input, double* row, int y, const int* columns, int count, int maxIterations )
+{
+    if ( count == 0 )
+        return;
+
+#if defined( HAVE_SSE2 )
+    if ( m_functorSSE2 ) {
+        GeneratorCore::generatePointsSSE2( input, row, y, columns, count, m_functorSSE2, maxIterations );
+        return;
+    }
+#endif
+
+    if ( m_functor )
+        GeneratorCore::generatePoints( input, row, y, columns, count, m_functor, maxIterations );
+}
+
+void FractalGenerator::colorizeRegion( const QRect& region )
+{
+    if ( region.isEmpty() )
+        return;
+
+    int stride = m_bufferSize.width();
+    int width = m_resolution.width();
+
+    // each row of the image depends on three rows of indexes
+    QRect rows( 0, region.top(), width, region.height() + 2 );
+    bool indexed = containsRegion( m_indexedRegions, rows );
+
+    // keep a reference to the palette in case it's replaced while drawing
+    QVector<QRgb> palette = m_palette;
+    ColorMapping mapping = m_colorMapping;
+    AntiAliasing antiAliasing = m_antiAliasing;
+
+    int serial = m_colorSerial;
+    int indexSerial = m_indexSerial;
+
+    m_mutex.unlock();
+
+    // the image can be replaced or recolored while this job is running,
+    // so the strip is only copied to it after checking the serial
+    QImage strip( region.size(), QImage::Format_RGB32 );
+
+    // the view scrolls colors by rotating the color table of the indexed strip
+    QImage indexStrip( region.size(), QImage::Format_Indexed8 );
+
+    QVector<int> indexes;
+
+    if ( indexed ) {
+        DataFunctions::drawImage( strip, QPoint( 0, 0 ), m_indexBuffer, stride, region, palette.constData(), antiAliasing );
+        DataFunctions::drawIndexImage( indexStrip, QPoint( 0, 0 ), m_indexBuffer, stride, region, palette.count() );
+    } else {
+        indexes.resize( rows.height() * stride );
+        for ( int y = 0; y < rows.height(); y++ ) {
+            DataFunctions::fillColorIndexes( indexes.data() + y * stride, m_buffer + ( rows.top() + y ) * stride,
+                width, DataFunctions::GradientSize, mapping );
+        }
+        DataFunctions::drawImage( strip, QPoint( 0, 0 ), indexes.constData(), stride,
+            region.translated( 0, -region.top() ), palette.constData(), antiAliasing );
+        DataFunctions::drawIndexImage( indexStrip, QPoint( 0, 0 ), indexes.constData(), stride,
+            region.translated( 0, -region.top() ), palette.count() );
+    }
+
+    m_mutex.lock();
+
+    // store the indexes so that changing the gradient only needs a new palette
+    if ( !indexed && indexSerial == m_indexSerial ) {
+        for ( int y = 0; y < rows.height(); y++ ) {
+            if ( !containsRegion( m_indexedRegions, QRect( 0, rows.top() + y, width, 1 ) ) )
+                memcpy( m_indexBuffer + ( rows.top() + y ) * stride, indexes.constData() + y * stride, width * sizeof( int ) );
+        }
+        appendRegion( m_indexedRegions, rows );
+    }
+
+    // discard the result if color settings were changed in the meantime
+    if ( serial == m_colorSerial && m_image.rect().contains( region ) ) {
+        for ( int y = 0; y < region.height(); y++ ) {
+            memcpy( m_image.scanLine( region.top() + y ), strip.constScanLine( y ), region.width() * sizeof( QRgb ) );
+            memcpy( m_indexImage.scanLine( region.top() + y ), indexStrip.constScanLine( y ), region.width() );
+        }
+
+        appendRegion( m_coloredRegions, region );
+
+        if ( m_update == NoUpdate )
+            postUpdate( PartialUpdate );
+    }
+}
+
+bool FractalGenerator::isColorizing() const
+{
+    return m_colorizing && !m_preview && !m_palette.isEmpty() && !m_image.isNull() && m_indexBuffer;
+}
+
+QRect FractalGenerator::colorableRegion( const QRect& region ) const
+{
+    QRect clipped = region.intersected( QRect( QPoint( 0, 0 ), m_resolution ) );
+    if ( clipped.isEmpty() )
+        return QRect();
+
+    // each pixel of the image depends on three rows of data, so rows adjacent
+    // to an unfinished region are colored by the job which finishes last
+    for ( int i = 0; i < m_validRegions.count(); i++ ) {
+        const QRect& valid = m_validRegions.at( i );
+        if ( valid.top() <= clipped.top() && valid.bottom() >= clipped.bottom() ) {
+            int top = qMax( clipped.top() - 2, valid.top() );
+            int bottom = qMin( clipped.bottom(), valid.bottom() - 2 );
+            return QRect( 0, top, m_image.width(), bottom - top + 1 );
+        }
+    }
+
+    return QRect();
+}
+
+void FractalGenerator::recolorImage()
+{
+    updatePalette();
+
+    m_colorSerial++;
+
+    m_coloredRegions.clear();
+    m_colorRegions.clear();
+
+    if ( !isColorizing() || m_pending || !m_buffer )
+        return;
+
+    for ( int i = 0; i < m_validRegions.count(); i++ ) {
+        int top = m_validRegions.at( i ).top();
+        int bottom = m_validRegions.at( i ).bottom() - 2;
+        for ( int y = top; y <= bottom; y += RegionSize )
+            m_colorRegions.append( QRect( 0, y, m_image.width(), qMin( RegionSize, bottom - y + 1 ) ) );
+    }
+
+    int count = m_colorRegions.count();
+    if ( m_enabled && count > 0 ) {
+        fraqtive()->jobScheduler()->addJobs( this, count );
+        m_activeJobs += count;
+    }
+}
+
+void FractalGenerator::updatePalette()
+{
+    if ( m_gradientCache.isEmpty() )
+        return;
+
+    QVector<QRgb> palette( DataFunctions::colorPaletteSize( DataFunctions::GradientSize, m_colorMapping ) );
+    DataFunctions::fillColorPalette( palette.data(), m_gradientCache.constData(), DataFunctions::GradientSize,
+        m_backgroundColor.rgb(), m_colorMapping, 0.0 );
+
+    m_palette = palette;
+}
+
+void FractalGenerator::invalidateIndexes()
+{
+    m_indexSerial++;
+    m_indexedRegions.clear();
+}
+
+int FractalGenerator::initialIterations( bool reused ) const
+{
+    // show the frame quickly using fewer iterations and deepen it afterwards
+    if ( m_pointFlags && !reused )
+        return qMin( maximumIterations(), qMax( MinimumIterations, maximumIterations() / ( DeepeningFactor * DeepeningFactor ) ) );
+
+    return maximumIterations();
 }
 
 void FractalGenerator::reset()
@@ -279,11 +859,22 @@ void FractalGenerator::handleState()
     if ( m_activeJobs > 0 || !m_enabled || m_pendingResolution.isEmpty() )
         return;
 
-    if ( !m_regions.isEmpty() && !m_pending ) {
+    if ( m_pending && canDeepen() ) {
+        // the remaining regions are calculated with the previous limit and deepened later
+        m_settings = m_pendingSettings;
+        m_pending = false;
+    }
+
+    if ( ( m_probing || !m_regions.isEmpty() || !m_colorRegions.isEmpty() ) && !m_pending ) {
         addJobs();
         return;
     }
 
+    if ( !m_continuous && m_remapBuffer ) {
+        delete[] m_remapBuffer;
+        m_remapBuffer = NULL;
+    }
+
     if ( m_preview && m_buffer && m_regions.isEmpty() && m_resolution == m_pendingResolution ) {
         delete[] m_previewBuffer;
         m_previewBuffer = m_buffer;
@@ -292,12 +883,68 @@ void FractalGenerator::handleState()
         postUpdate( FullUpdate );
     }
 
-    if ( m_pending ) {
+    if ( m_pending && canRedetail() ) {
+        // only the detail pass is repeated using the existing preview grid
+        m_settings = m_pendingSettings;
+        m_pending = false;
+
+        m_coarse = false;
+        m_refining = false;
+        m_detailing = true;
+        m_remapping = false;
+
+        postUpdate( InitialUpdate );
+
+        m_validRegions.clear();
+
+        m_colorSerial++;
+        m_colorRegions.clear();
+        m_coloredRegions.clear();
+
+        invalidateIndexes();
+
+        splitRegions();
+        addJobs();
+    } else if ( m_pending ) {
+        // after resizing the view samples in the overlapping area are reused
+        bool resize = canResize();
+        QSize previousResolution = m_resolution;
+        QSize previousBufferSize = m_bufferSize;
+
+        if ( resize ) {
+            delete[] m_remapBuffer;
+            m_remapBuffer = m_buffer;
+            m_buffer = NULL;
+        }
+
         if ( m_buffer && m_bufferSize != m_pendingBufferSize ) {
             delete[] m_buffer;
             m_buffer = NULL;
         }
 
+        if ( m_indexBuffer && m_bufferSize != m_pendingBufferSize ) {
+            delete[] m_indexBuffer;
+            m_indexBuffer = NULL;
+        }
+
+        if ( m_remapBuffer && m_bufferSize != m_pendingBufferSize && !resize ) {
+            delete[] m_remapBuffer;
+            m_remapBuffer = NULL;
+        }
+
+        if ( m_pointFlags && ( !m_progressive || m_bufferSize != m_pendingBufferSize ) ) {
+            delete[] m_pointFlags;
+            m_pointFlags = NULL;
+            m_samples.clear();
+        }
+
+        // during continuous navigation samples of the previous frame are reused
+        bool remap = canRemap();
+        Position previousPosition = m_position;
+
+        if ( remap )
+            qSwap( m_buffer, m_remapBuffer );
+
         m_type = m_pendingType;
         m_position = m_pendingPosition;
         m_settings = m_pendingSettings;
@@ -308,13 +955,101 @@ void FractalGenerator::handleState()
         if ( !m_buffer )
             m_buffer = new double[ m_bufferSize.width() * m_bufferSize.height() ];
 
+        if ( m_colorizing && !m_preview && m_image.size() != m_resolution - QSize( 2, 2 ) ) {
+            m_image = QImage( m_resolution - QSize( 2, 2 ), QImage::Format_RGB32 );
+            m_indexImage = QImage( m_resolution - QSize( 2, 2 ), QImage::Format_Indexed8 );
+        }
+
+        if ( m_colorizing && !m_preview && !m_indexBuffer )
+            m_indexBuffer = new int[ m_bufferSize.width() * m_bufferSize.height() ];
+
+        if ( m_progressive && !m_preview && !m_pointFlags ) {
+            m_pointFlags = new unsigned char[ m_bufferSize.width() * m_bufferSize.height() ];
+            m_samples.resize( ( m_bufferSize.height() + RegionSize - 1 ) / RegionSize );
+        }
+
         createFunctor();
 
+        // the number of iterations is estimated before the frame is calculated;
+        // reused frames keep the previous estimate
+        m_probing = m_settings.automaticDepth() && !m_preview && !remap && !resize;
+
+        m_iterations = initialIterations( remap || resize );
+
+        m_deepening = false;
+
+        if ( remap )
+            calculateRemapping( previousPosition );
+        if ( resize )
+            calculateResizing( previousResolution, previousBufferSize );
+
+        m_remapping = remap || resize;
+        m_remapped = remap;
+
+        // skip the detail pass while the user is interacting with the view;
+        // samples reused after resizing are already final
+        m_coarse = ( m_interactive || remap ) && !m_preview && !resize;
+        m_refining = false;
+        m_detailing = false;
+
         if ( !m_preview )
             postUpdate( InitialUpdate );
 
         m_validRegions.clear();
 
+        m_colorSerial++;
+        m_colorRegions.clear();
+        m_coloredRegions.clear();
+
+        invalidateIndexes();
+
+        if ( m_probing )
+            m_regions.clear();
+        else
+            splitRegions();
+        addJobs();
+    } else if ( m_coarse && !m_interactive && m_buffer ) {
+        // calculate the missing details when interaction is finished;
+        // remapped frames are calculated again from scratch
+        m_coarse = false;
+        m_refining = !m_remapped;
+        m_detailing = false;
+
+        m_remapping = false;
+        m_remapped = false;
+
+        m_deepening = false;
+
+        postUpdate( InitialUpdate );
+
+        m_validRegions.clear();
+
+        m_colorSerial++;
+        m_colorRegions.clear();
+        m_coloredRegions.clear();
+
+        invalidateIndexes();
+
+        splitRegions();
+        addJobs();
+    } else if ( m_pointFlags && !m_interactive && m_iterations < maximumIterations() ) {
+        // continue iterating the samples which haven't escaped yet
+        m_iterations = qMin( m_iterations * DeepeningFactor, maximumIterations() );
+
+        m_deepening = true;
+        m_detailing = false;
+        m_remapping = false;
+
+        postUpdate( InitialUpdate );
+
+        m_validRegions.clear();
+
+        m_colorSerial++;
+        m_colorRegions.clear();
+        m_coloredRegions.clear();
+
+        invalidateIndexes();
+
         splitRegions();
         addJobs();
     }
@@ -327,18 +1062,232 @@ void FractalGenerator::createFunctor()
 
 #if defined( HAVE_SSE2 )
     delete m_functorSSE2;
+    m_functorSSE2 = NULL;
+
+    // the scalar functor is also needed to resume samples in progressive mode
     m_functorSSE2 = DataFunctions::createFunctorSSE2( m_type );
-    if ( m_functorSSE2 != NULL )
+    if ( m_functorSSE2 != NULL && !m_pointFlags )
         return;
 #endif
 
     m_functor = DataFunctions::createFunctor( m_type );
 }
 
+bool FractalGenerator::canDeepen() const
+{
+    if ( !m_progressive || !m_pointFlags || m_remapped || m_probing )
+        return false;
+
+    if ( m_settings.automaticDepth() != m_pendingSettings.automaticDepth() )
+        return false;
+
+    if ( m_bufferSize != m_pendingBufferSize || m_resolution != m_pendingResolution )
+        return false;
+
+    if ( m_type != m_pendingType || m_position != m_pendingPosition )
+        return false;
+
+    if ( !qFuzzyCompare( m_settings.detailThreshold(), m_pendingSettings.detailThreshold() ) )
+        return false;
+
+    // escaped samples are final as long as the limit doesn't decrease
+    return m_pendingSettings.calculationDepth() >= m_settings.calculationDepth();
+}
+
+bool FractalGenerator::canRedetail() const
+{
+    if ( m_preview || !m_buffer || m_remapped || m_probing )
+        return false;
+
+    // the progressive state is only allocated for a new frame
+    if ( m_progressive != ( m_pointFlags != NULL ) )
+        return false;
+
+    if ( m_settings.automaticDepth() != m_pendingSettings.automaticDepth() )
+        return false;
+
+    if ( m_bufferSize != m_pendingBufferSize || m_resolution != m_pendingResolution )
+        return false;
+
+    if ( m_type != m_pendingType || m_position != m_pendingPosition )
+        return false;
+
+    if ( !qFuzzyCompare( m_settings.calculationDepth(), m_pendingSettings.calculationDepth() ) )
+        return false;
+
+    // the preview grid must already be calculated in all regions
+    return m_regions.isEmpty() || m_refining || m_detailing || m_deepening;
+}
+
+bool FractalGenerator::canResize() const
+{
+    if ( m_preview || !m_buffer || m_coarse || m_remapped )
+        return false;
+
+    if ( m_type != m_pendingType || m_position != m_pendingPosition || m_settings != m_pendingSettings )
+        return false;
+
+    // the scale depends on the height of the view and the center must be shifted by whole pixels
+    if ( m_resolution == m_pendingResolution || m_resolution.height() != m_pendingResolution.height() )
+        return false;
+
+    if ( ( m_pendingResolution.width() - m_resolution.width() ) % 2 != 0 )
+        return false;
+
+    // the previous frame must be complete and fully deepened
+    if ( m_pointFlags && m_iterations < maximumIterations() )
+        return false;
+
+    return m_validRegions.count() == 1 && m_validRegions.first() == QRect( QPoint( 0, 0 ), m_resolution );
+}
+
+bool FractalGenerator::canRemap() const
+{
+    if ( !m_continuous || m_preview || !m_buffer )
+        return false;
+
+    if ( m_bufferSize != m_pendingBufferSize || m_resolution != m_pendingResolution )
+        return false;
+
+    if ( m_type != m_pendingType || m_settings != m_pendingSettings )
+        return false;
+
+    // rows and columns can only be remapped if the angle doesn't change
+    if ( fabs( m_position.angle() - m_pendingPosition.angle() ) > 1e-6 )
+        return false;
+
+    // the previous frame must be complete
+    return m_validRegions.count() == 1 && m_validRegions.first() == QRect( QPoint( 0, 0 ), m_resolution );
+}
+
+static const double MaximumRemapError = 0.5;
+
+static QVector<int> remapLine( int count, int resolution, double delta, double oldScale, double newScale,
+    const QVector<double>& oldPositions, QVector<double>* newPositions )
+{
+    QVector<int> map( count, -1 );
+    QVector<int> owners( count, -1 );
+    QVector<double> errors( count, 0.0 );
+
+    double half = resolution / 2.0 + 0.5;
+
+    // real positions of the old samples in new pixels; they can differ from the
+    // nominal positions if the old samples were already remapped
+    QVector<double> mapped( count );
+    for ( int j = 0; j < count; j++ )
+        mapped[ j ] = ( ( oldPositions.at( j ) - half ) * oldScale - delta ) / newScale + half;
+
+    for ( int i = 0; i < count; i++ ) {
+        // fractional index of the old sample at the same coordinate
+        double position = ( delta + newScale * ( i - half ) ) / oldScale + half;
+        int center = (int)floor( position + 0.5 );
+
+        // the real position of the old sample is within half a pixel of the nominal one
+        int nearest = -1;
+        double error = MaximumRemapError;
+        for ( int j = qMax( center - 1, 0 ); j <= qMin( center + 1, count - 1 ); j++ ) {
+            double distance = fabs( mapped[ j ] - i );
+            if ( distance <= error ) {
+                nearest = j;
+                error = distance;
+            }
+        }
+        if ( nearest < 0 )
+            continue;
+
+        // each old sample is reused only once, by the closest new one
+        int owner = owners[ nearest ];
+        if ( owner >= 0 ) {
+            if ( errors[ owner ] <= error )
+                continue;
+            map[ owner ] = -1;
+        }
+
+        owners[ nearest ] = i;
+        errors[ i ] = error;
+        map[ i ] = nearest;
+    }
+
+    for ( int i = 0; i < count; i++ )
+        ( *newPositions )[ i ] = map[ i ] >= 0 ? mapped[ map[ i ] ] : (double)i;
+
+    return map;
+}
+
+static QVector<double> nominalPositions( int count )
+{
+    QVector<double> positions( count );
+    for ( int i = 0; i < count; i++ )
+        positions[ i ] = i;
+    return positions;
+}
+
+void FractalGenerator::calculateRemapping( const Position& previous )
+{
+    double angle = m_position.angle() * M_PI / 180.0;
+
+    double oldScale = pow( 10.0, -previous.zoomFactor() ) / (double)m_resolution.height();
+    double newScale = pow( 10.0, -m_position.zoomFactor() ) / (double)m_resolution.height();
+
+    double dx = m_position.center().x() - previous.center().x();
+    double dy = m_position.center().y() - previous.center().y();
+
+    // in the rotated coordinate system the column only depends on x and the row only on y
+    double du = dx * cos( angle ) - dy * sin( angle );
+    double dv = dx * sin( angle ) + dy * cos( angle );
+
+    // samples of a remapped frame keep their real positions, so that the error
+    // doesn't accumulate when the frame is remapped again
+    int width = m_bufferSize.width();
+    int height = m_bufferSize.height();
+
+    bool reused = m_remapped && m_columnPositions.count() == width && m_rowPositions.count() == height;
+
+    QVector<double> oldColumns = reused ? m_columnPositions : nominalPositions( width );
+    QVector<double> oldRows = reused ? m_rowPositions : nominalPositions( height );
+
+    m_columnPositions = QVector<double>( width );
+    m_rowPositions = QVector<double>( height );
+
+    m_columnMap = remapLine( width, m_resolution.width(), du, oldScale, newScale, oldColumns, &m_columnPositions );
+    m_rowMap = remapLine( height, m_resolution.height(), dv, oldScale, newScale, oldRows, &m_rowPositions );
+
+    m_remapStride = m_bufferSize.width();
+}
+
+void FractalGenerator::calculateResizing( const QSize& previousResolution, const QSize& previousBufferSize )
+{
+    // the height doesn't change, so columns are shifted by a whole number of pixels
+    int shift = ( m_resolution.width() - previousResolution.width() ) / 2;
+
+    m_columnMap = QVector<int>( m_bufferSize.width(), -1 );
+    for ( int x = 0; x < m_bufferSize.width(); x++ ) {
+        int oldColumn = x - shift;
+        if ( oldColumn >= 0 && oldColumn < previousBufferSize.width() )
+            m_columnMap[ x ] = oldColumn;
+    }
+
+    m_rowMap = QVector<int>( m_bufferSize.height() );
+    for ( int y = 0; y < m_bufferSize.height(); y++ )
+        m_rowMap[ y ] = y;
+
+    // resized frames are never remapped, so the reused samples are at their nominal positions
+    m_columnPositions = nominalPositions( m_bufferSize.width() );
+    m_rowPositions = nominalPositions( m_bufferSize.height() );
+
+    m_remapStride = previousBufferSize.width();
+}
+
 void FractalGenerator::splitRegions()
 {
     m_regions.clear();
 
+    m_mirrorRegions.clear();
+    m_deferredRegions.clear();
+    m_calculatedRegions.clear();
+
+    calculateSymmetry();
+
     int fullRegions = m_bufferSize.height() / RegionSize;
     int remainder = m_bufferSize.height() - fullRegions * RegionSize;
 
@@ -351,6 +1300,81 @@ void FractalGenerator::splitRegions()
         QRect region( 0, fullRegions * RegionSize, m_bufferSize.width(), remainder );
         m_regions.append( region );
     }
+
+    // regions in which all rows are symmetric to already calculated rows are copied
+    if ( m_mirrorRow >= 0 ) {
+        for ( int i = 0; i < m_regions.count(); i++ ) {
+            const QRect& region = m_regions.at( i );
+            if ( 2 * region.top() > m_mirrorRow && region.bottom() <= m_mirrorRow )
+                m_mirrorRegions.append( region );
+        }
+    }
+}
+
+static const double SymmetryTolerance = 1e-6;
+
+static bool roundToPixel( double value, int limit, int* pixel )
+{
+    if ( value < 0.0 || value > (double)limit )
+        return false;
+
+    *pixel = (int)floor( value + 0.5 );
+
+    // only exact symmetry is used, rows are never interpolated
+    return fabs( value - (double)*pixel ) < SymmetryTolerance;
+}
+
+void FractalGenerator::calculateSymmetry()
+{
+    m_mirrorRow = -1;
+    m_mirrorColumns.clear();
+    m_missingColumns.clear();
+
+    QPointF center;
+    DataFunctions::Symmetry symmetry = DataFunctions::findSymmetry( m_type, m_position, m_resolution.height(), &center );
+    if ( symmetry == DataFunctions::NoSymmetry )
+        return;
+
+    int width = m_bufferSize.width();
+    int height = m_bufferSize.height();
+
+    // pixel y is symmetric to mirrorRow - y
+    int mirrorRow;
+    if ( !roundToPixel( (double)m_resolution.height() + 1.0 + 2.0 * center.y(), 2 * ( height - 1 ), &mirrorRow ) )
+        return;
+
+    if ( symmetry == DataFunctions::PointSymmetry ) {
+        int mirrorColumn;
+        if ( !roundToPixel( (double)m_resolution.width() + 1.0 + 2.0 * center.x(), 2 * ( width - 1 ), &mirrorColumn ) )
+            return;
+
+        QVector<int> columns( width );
+        QVector<int> missingColumns;
+
+        for ( int x = 0; x < width; x++ ) {
+            int column = mirrorColumn - x;
+            if ( column >= 0 && column < width ) {
+                columns[ x ] = column;
+            } else {
+                columns[ x ] = -1;
+                missingColumns.append( x );
+            }
+        }
+
+        // calculating missing points one by one is slower than the normal passes
+        if ( missingColumns.count() > width / 4 )
+            return;
+
+        m_mirrorColumns = columns;
+        m_missingColumns = missingColumns;
+    }
+
+    m_mirrorRow = mirrorRow;
+}
+
+QRect FractalGenerator::mirroredRegion( const QRect& region ) const
+{
+    return QRect( region.left(), m_mirrorRow - region.bottom(), region.width(), region.height() );
 }
 
 void FractalGenerator::calculateInput( GeneratorCore::Input* input, const QRect& region )
@@ -379,7 +1403,7 @@ void FractalGenerator::calculateOutput( GeneratorCore::Output* output, const QRe
 
 void FractalGenerator::addJobs()
 {
-    int count = m_regions.count();
+    int count = m_regions.count() + m_colorRegions.count() + ( m_probing ? 1 : 0 );
     if ( count > 0 ) {
         fraqtive()->jobScheduler()->addJobs( this, count );
         m_activeJobs += count;
@@ -409,24 +1433,7 @@ void FractalGenerator::appendValidRegion( const QRect& region )
     if ( clipped.isEmpty() )
         return;
 
-    for ( int i = 0; i < m_validRegions.count(); i++ ) {
-        if ( m_validRegions[ i ].bottom() + 1 == clipped.top() ) {
-            if ( i + 1 < m_validRegions.count() && m_validRegions[ i + 1 ].top() == clipped.bottom() + 1 )
-                m_validRegions[ i ].setBottom( m_validRegions.takeAt( i + 1 ).bottom() );
-            else
-                m_validRegions[ i ].setBottom( clipped.bottom() );
-            return;
-        }
-        if ( m_validRegions[ i ].top() == clipped.bottom() + 1 ) {
-            m_validRegions[ i ].setTop( clipped.top() );
-            return;
-        }
-        if ( m_validRegions[ i ].top() > clipped.top() ) {
-            m_validRegions.insert( i, clipped );
-            return;
-        }
-    }
-    m_validRegions.append( clipped );
+    appendRegion( m_validRegions, clipped );
 }
 
 void FractalGenerator::postUpdate( UpdateStatus update )
@@ -23,6 +23,8 @@
 #include <QMutex>
 #include <QObject>
 #include <QWaitCondition>
+#include <QImage>
+#include <QVector>
 
 #include "abstractjobprovider.h"
 #include "datastructures.h"
@@ -56,17 +58,33 @@ public:
 
     void setEnabled( bool enabled );
 
+    void setInteractive( bool interactive );
+    void setContinuous( bool continuous );
+
+    void setProgressiveDepth( bool progressive );
+
     void setParameters( const FractalType& type, const Position& position );
     void setFractalType( const FractalType& type );
     void setPosition( const Position& position );
 
     void setGeneratorSettings( const GeneratorSettings& settings );
 
+    void setColorizing( bool colorizing );
+
+    void setColorSettings( const Gradient& gradient, const QColor& backgroundColor, const ColorMapping& mapping );
+    void setGradient( const Gradient& gradient );
+    void setBackgroundColor( const QColor& color );
+    void setColorMapping( const ColorMapping& mapping );
+
+    void setViewSettings( const ViewSettings& settings );
+
     void setResolution( const QSize& resolution );
     QSize resolution() const { return m_resolution; }
 
     int maximumIterations() const;
 
+    QVector<int> escapeHistogram();
+
     UpdateStatus updateData( FractalData* data );
 
 public: // AbstractJobProvider implementation
@@ -75,7 +93,23 @@ public: // AbstractJobProvider implementation
     void executeJob();
 
 private:
+    void probeIterations();
     void calculateRegion( const QRect& region );
+    void mirrorRegion( const QRect& region );
+    void remapRegion( const GeneratorCore::Input& input, const QRect& region, int maxIterations );
+    void calculatePoints( const GeneratorCore::Input& input, double* row, int y, const int* columns, int count, int maxIterations );
+    void remapPoints( const GeneratorCore::Input& input, double* row, double y, const int* columns, int count, int maxIterations );
+    void colorizeRegion( const QRect& region );
+
+    bool isColorizing() const;
+
+    QRect colorableRegion( const QRect& region ) const;
+
+    void recolorImage();
+    void updatePalette();
+    void invalidateIndexes();
+
+    int initialIterations( bool reused ) const;
 
     void reset();
 
@@ -83,7 +117,18 @@ private:
 
     void createFunctor();
 
+    bool canDeepen() const;
+    bool canRedetail() const;
+    bool canResize() const;
+
+    bool canRemap() const;
+    void calculateRemapping( const Position& previous );
+    void calculateResizing( const QSize& previousResolution, const QSize& previousBufferSize );
+
     void splitRegions();
+    void calculateSymmetry();
+
+    QRect mirroredRegion( const QRect& region ) const;
 
     void calculateInput( GeneratorCore::Input* input, const QRect& region );
     void calculateOutput( GeneratorCore::Output* output, const QRect& region );
@@ -105,6 +150,18 @@ private:
 
     bool m_enabled;
 
+    bool m_interactive;
+    bool m_coarse;
+    bool m_refining;
+    bool m_detailing;
+
+    bool m_continuous;
+    bool m_remapping;
+    bool m_remapped;
+
+    bool m_progressive;
+    bool m_deepening;
+
     FractalType m_type;
     Position m_position;
     GeneratorSettings m_settings;
@@ -112,6 +169,12 @@ private:
     QSize m_resolution;
     QSize m_bufferSize;
 
+    int m_iterations;
+
+    bool m_probing;
+    int m_estimatedIterations;
+    QVector<int> m_histogram;
+
     GeneratorCore::Functor* m_functor;
 #if defined( HAVE_SSE2 )
     GeneratorCore::FunctorSSE2* m_functorSSE2;
@@ -119,8 +182,27 @@ private:
 
     double* m_buffer;
 
+    // calculated detail points and orbits of unescaped points in each region
+    unsigned char* m_pointFlags;
+    QVector< QVector<GeneratorCore::Sample> > m_samples;
+
+    double* m_remapBuffer;
+    int m_remapStride;
+    QVector<int> m_columnMap;
+    QVector<int> m_rowMap;
+    QVector<double> m_columnPositions;
+    QVector<double> m_rowPositions;
+
     QList<QRect> m_regions;
 
+    int m_mirrorRow;
+    QVector<int> m_mirrorColumns;
+    QVector<int> m_missingColumns;
+
+    QList<QRect> m_mirrorRegions;
+    QList<QRect> m_deferredRegions;
+    QList<QRect> m_calculatedRegions;
+
     int m_activeJobs;
     QWaitCondition m_allJobsDone;
 
@@ -137,6 +219,28 @@ private:
     QList<QRect> m_validRegions;
 
     double* m_previewBuffer;
+
+    bool m_colorizing;
+
+    QVector<QRgb> m_gradientCache;
+    QColor m_backgroundColor;
+    ColorMapping m_colorMapping;
+    AntiAliasing m_antiAliasing;
+
+    QVector<QRgb> m_palette;
+
+    QImage m_image;
+    QImage m_indexImage;
+
+    QList<QRect> m_colorRegions;
+    QList<QRect> m_coloredRegions;
+
+    int m_colorSerial;
+
+    int* m_indexBuffer;
+    QList<QRect> m_indexedRegions;
+
+    int m_indexSerial;
 };
 
 #endif
@@ -41,6 +41,8 @@ static void initializeDefaultSettings()
             config->setValue( "GeneratorSettings", QVariant::fromValue( DataFunctions::defaultGeneratorSettings() ) );
         if ( !config->contains( "ViewSettings" ) )
             config->setValue( "ViewSettings", QVariant::fromValue( DataFunctions::defaultViewSettings() ) );
+        if ( !config->contains( "ProgressiveDepth" ) )
+            config->setValue( "ProgressiveDepth", false );
 
         initialized = true;
     }
@@ -52,13 +54,20 @@ FractalModel::FractalModel( QObject* parent ) : QObject( parent ),
     m_tracking( false ),
     m_hovering( false ),
     m_navigation( false ),
-    m_viewMode( NoViewMode )
+    m_continuous( false ),
+    m_progressive( false ),
+    m_viewMode( NoViewMode ),
+    m_iterations( 0 )
 {
     initializeDefaultSettings();
 
     m_presenter = new FractalPresenter( this );
     m_presenter->setModel( this );
 
+    // deepening requires the slower scalar functors and a buffer of samples, so it's optional
+    m_progressive = fraqtive()->configuration()->value( "ProgressiveDepth" ).toBool();
+    m_presenter->setProgressiveDepth( m_progressive );
+
     m_timer = new QTimer( this );
     m_timer->setInterval( 50 );
 
@@ -124,7 +133,8 @@ void FractalModel::setFractalType( const FractalType& type )
 void FractalModel::setPosition( const Position& position )
 {
     if ( m_position != position ) {
-        storeParameters();
+        if ( !m_continuous )
+            storeParameters();
         m_position = position;
         m_presenter->setPosition( position );
         emit positionChanged();
@@ -182,6 +192,15 @@ void FractalModel::clearHovering()
     }
 }
 
+void FractalModel::setContinuousNavigation( bool continuous )
+{
+    // store only the position at which continuous navigation started
+    if ( continuous && !m_continuous )
+        storeParameters();
+
+    m_continuous = continuous;
+}
+
 void FractalModel::setNavigationEnabled( bool enable )
 {
     if ( m_navigation != enable ) {
@@ -283,6 +302,19 @@ void FractalModel::setGeneratorSettings( const GeneratorSettings& settings )
     }
 }
 
+void FractalModel::setProgressiveDepth( bool progressive )
+{
+    if ( m_progressive != progressive ) {
+        m_progressive = progressive;
+        m_presenter->setProgressiveDepth( progressive );
+
+        ConfigurationData* config = fraqtive()->configuration();
+        config->setValue( "ProgressiveDepth", progressive );
+
+        emit generatorSettingsChanged();
+    }
+}
+
 void FractalModel::setViewSettings( const ViewSettings& settings )
 {
     if ( m_viewSettings != settings ) {
@@ -372,6 +404,15 @@ void FractalModel::setAnimationSettings( const AnimationSettings& settings )
     }
 }
 
+void FractalModel::setIterationStatistics( int iterations, const QVector<int>& histogram )
+{
+    if ( m_iterations != iterations || m_histogram != histogram ) {
+        m_iterations = iterations;
+        m_histogram = histogram;
+        emit iterationStatisticsChanged();
+    }
+}
+
 void FractalModel::updateTimer()
 {
     AnimationState lastState = m_animationState;
@@ -22,6 +22,7 @@
 #include <QObject>
 #include <QColor>
 #include <QTime>
+#include <QVector>
 
 #include "datastructures.h"
 
@@ -66,6 +67,8 @@ public:
     void setTrackingPosition( const Position& position );
     void clearTracking();
 
+    void setContinuousNavigation( bool continuous );
+
     bool isTracking() const { return m_tracking; }
     Position trackingPosition() const { return m_trackingPosition; }
 
@@ -107,6 +110,9 @@ public:
     void saveDefaultGeneratorSettings() const;
     void loadDefaultGeneratorSettings();
 
+    void setProgressiveDepth( bool progressive );
+    bool progressiveDepth() const { return m_progressive; }
+
     void setViewSettings( const ViewSettings& settings );
     ViewSettings viewSettings() const { return m_viewSettings; }
 
@@ -122,6 +128,10 @@ public:
 
     AnimationState animationState() const { return m_animationState; }
 
+    void setIterationStatistics( int iterations, const QVector<int>& histogram );
+    int iterations() const { return m_iterations; }
+    QVector<int> escapeHistogram() const { return m_histogram; }
+
 signals:
     void fractalTypeChanged();
     void positionChanged();
@@ -141,6 +151,8 @@ signals:
 
     void animationSettingsChanged();
 
+    void iterationStatisticsChanged();
+
 private slots:
     void animate();
 
@@ -174,6 +186,7 @@ private:
     Position m_hoveringPosition;
 
     bool m_navigation;
+    bool m_continuous;
     QList<Navigation> m_navigationBackward;
     QList<Navigation> m_navigationForward;
 
@@ -182,6 +195,8 @@ private:
     ColorMapping m_colorMapping;
 
     GeneratorSettings m_generatorSettings;
+    bool m_progressive;
+
     ViewSettings m_viewSettings;
 
     ViewMode m_viewMode;
@@ -189,6 +204,9 @@ private:
     AnimationSettings m_animationSettings;
     AnimationState m_animationState;
 
+    int m_iterations;
+    QVector<int> m_histogram;
+
     QTimer* m_timer;
     QTime m_time;
 };
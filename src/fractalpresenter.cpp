@@ -25,11 +25,13 @@
 #endif
 
 #include <QTransform>
+#include <QTimer>
 
 #include "fractalgenerator.h"
 #include "fractalmodel.h"
 #include "fractaldata.h"
 #include "abstractview.h"
+#include "imageview.h"
 
 FractalPresenter::FractalPresenter( QObject* parent ) : QObject( parent ),
     m_model( NULL ),
@@ -39,6 +41,17 @@ FractalPresenter::FractalPresenter( QObject* parent ) : QObject( parent ),
 {
     m_generator = new FractalGenerator( this );
     m_generator->setReceiver( this );
+
+    m_interactionTimer = new QTimer( this );
+    m_interactionTimer->setSingleShot( true );
+    m_interactionTimer->setInterval( 300 );
+
+    connect( m_interactionTimer, SIGNAL( timeout() ), this, SLOT( interactionFinished() ) );
+
+    m_updateTimer = new QTimer( this );
+    m_updateTimer->setSingleShot( true );
+
+    connect( m_updateTimer, SIGNAL( timeout() ), this, SLOT( deliverUpdate() ) );
 }
 
 FractalPresenter::~FractalPresenter()
@@ -54,10 +67,13 @@ void FractalPresenter::setView( AbstractView* view )
 {
     m_view = view;
 
+    // only the image view uses colors calculated by the generator
+    m_generator->setColorizing( dynamic_cast<ImageView*>( view ) != NULL );
+
     if ( m_model ) {
-        m_view->setColorSettings( m_model->gradient(), m_model->backgroundColor(), m_model->colorMapping() );
-        m_view->setViewSettings( m_model->viewSettings() );
-        m_view->setAnimationState( m_model->animationState() );
+        setColorSettings( m_model->gradient(), m_model->backgroundColor(), m_model->colorMapping() );
+        setViewSettings( m_model->viewSettings() );
+        setAnimationState( m_model->animationState() );
     }
 }
 
@@ -74,6 +90,11 @@ void FractalPresenter::setPriority( int priority )
     m_generator->setPriority( priority );
 }
 
+void FractalPresenter::setProgressiveDepth( bool progressive )
+{
+    m_generator->setProgressiveDepth( progressive );
+}
+
 void FractalPresenter::setEnabled( bool enabled )
 {
     if ( m_enabled != enabled ) {
@@ -167,21 +188,25 @@ void FractalPresenter::setPosition( const Position& position )
 
 void FractalPresenter::setColorSettings( const Gradient& gradient, const QColor& background, const ColorMapping& mapping )
 {
+    m_generator->setColorSettings( gradient, background, mapping );
     m_view->setColorSettings( gradient, background, mapping );
 }
 
 void FractalPresenter::setGradient( const Gradient& gradient )
 {
+    m_generator->setGradient( gradient );
     m_view->setGradient( gradient );
 }
 
 void FractalPresenter::setBackgroundColor( const QColor& color )
 {
+    m_generator->setBackgroundColor( color );
     m_view->setBackgroundColor( color );
 }
 
 void FractalPresenter::setColorMapping( const ColorMapping& mapping )
 {
+    m_generator->setColorMapping( mapping );
     m_view->setColorMapping( mapping );
 }
 
@@ -192,6 +217,7 @@ void FractalPresenter::setGeneratorSettings( const GeneratorSettings& settings )
 
 void FractalPresenter::setViewSettings( const ViewSettings& settings )
 {
+    m_generator->setViewSettings( settings );
     m_view->setViewSettings( settings );
 }
 
@@ -253,9 +279,25 @@ void FractalPresenter::changePosition( const QTransform& transform )
     QTransform newTransform = preciselyInverted( transform ) * oldTransform;
 
     Position position = positionFromTransform( newTransform );
+
+    // render without details until no more input arrives for a while
+    m_generator->setInteractive( true );
+    m_interactionTimer->start();
+
     m_model->setPosition( position );
 }
 
+void FractalPresenter::setContinuousZoom( bool continuous )
+{
+    m_model->setContinuousNavigation( continuous );
+    m_generator->setContinuous( continuous );
+}
+
+void FractalPresenter::interactionFinished()
+{
+    m_generator->setInteractive( false );
+}
+
 void FractalPresenter::switchToJulia( const QPointF& point )
 {
     if ( m_model && m_model->fractalType().fractal() != JuliaFractal )
@@ -285,27 +327,54 @@ void FractalPresenter::navigateForward()
         m_model->navigateForward();
 }
 
+static const int UpdateInterval = 16;
+
 void FractalPresenter::customEvent( QEvent* e )
 {
     if ( e->type() == FractalGenerator::UpdateEvent && m_enabled ) {
-        FractalGenerator::UpdateStatus status = m_generator->updateData( &m_data );
-        switch ( status ) {
-            case FractalGenerator::InitialUpdate:
-                m_view->initialUpdate( &m_data );
-                break;
-
-            case FractalGenerator::PartialUpdate:
-                m_view->partialUpdate( &m_data );
-                break;
-
-            case FractalGenerator::FullUpdate:
-                m_view->fullUpdate( &m_data );
-                break;
-
-            default:
-                break;
+        // the generator doesn't post more events until the update is delivered,
+        // so regions calculated in the meantime are delivered in one batch
+        if ( m_updateTimer->isActive() )
+            return;
+
+        int elapsed = m_updateTime.elapsed();
+        if ( !m_updateTime.isNull() && elapsed >= 0 && elapsed < UpdateInterval ) {
+            m_updateTimer->start( UpdateInterval - elapsed );
+            return;
         }
+
+        deliverUpdate();
+    }
+}
+
+void FractalPresenter::deliverUpdate()
+{
+    if ( !m_enabled )
+        return;
+
+    m_updateTime.start();
+
+    FractalGenerator::UpdateStatus status = m_generator->updateData( &m_data );
+    switch ( status ) {
+        case FractalGenerator::InitialUpdate:
+            m_view->initialUpdate( &m_data );
+            break;
+
+        case FractalGenerator::PartialUpdate:
+            m_view->partialUpdate( &m_data );
+            break;
+
+        case FractalGenerator::FullUpdate:
+            m_view->fullUpdate( &m_data );
+            break;
+
+        default:
+            break;
     }
+
+    // the limit may be estimated after the initial update
+    if ( m_model && !m_preview && status != FractalGenerator::NoUpdate )
+        m_model->setIterationStatistics( m_generator->maximumIterations(), m_generator->escapeHistogram() );
 }
 
 QTransform FractalPresenter::transformFromPosition( const Position& position )
@@ -20,10 +20,13 @@
 #define FRACTALPRESENTER_H
 
 #include <QObject>
+#include <QTime>
 
 #include "datastructures.h"
 #include "fractaldata.h"
 
+class QTimer;
+
 class FractalModel;
 class AbstractView;
 class FractalGenerator;
@@ -43,6 +46,8 @@ public:
     void setPreviewMode( bool preview );
     void setPriority( int priority );
 
+    void setProgressiveDepth( bool progressive );
+
     void setEnabled( bool enabled );
 
     void setParameters( const FractalType& type, const Position& position );
@@ -73,6 +78,8 @@ public:
 
     void changePosition( const QTransform& transform );
 
+    void setContinuousZoom( bool continuous );
+
     void switchToJulia( const QPointF& point );
 
     void adjustCameraZoom( double delta );
@@ -83,6 +90,10 @@ public:
 protected: // overrides
     void customEvent( QEvent* e );
 
+private slots:
+    void interactionFinished();
+    void deliverUpdate();
+
 private:
     QTransform transformFromPosition( const Position& position );
     Position positionFromTransform( const QTransform& transform );
@@ -93,6 +104,11 @@ private:
 private:
     FractalGenerator* m_generator;
 
+    QTimer* m_interactionTimer;
+
+    QTimer* m_updateTimer;
+    QTime m_updateTime;
+
     FractalModel* m_model;
     AbstractView* m_view;
 
@@ -28,6 +28,7 @@
 #include <shlobj.h>
 #endif
 
+#include "batchrenderer.h"
 #include "jobscheduler.h"
 #include "configurationdata.h"
 #include "fraqtivemainwindow.h"
@@ -42,8 +43,26 @@
 #include "xmlui/macstyle.h"
 #endif
 
-FraqtiveApplication::FraqtiveApplication( int& argc, char** argv ) : QApplication( argc, argv )
+FraqtiveApplication::FraqtiveApplication( int& argc, char** argv, bool gui ) :
+#if ( QT_VERSION < 0x050000 )
+    QApplication( argc, argv, gui ),
+#else
+    QApplication( argc, argv ),
+#endif
+    m_mainWindow( NULL ),
+    m_batchMode( !gui )
 {
+    registerDataStructures();
+
+    m_jobScheduler = new JobScheduler();
+
+    m_configuration = new ConfigurationData();
+    m_configuration->readConfiguration();
+
+    // no windows are created when rendering from the command line
+    if ( m_batchMode )
+        return;
+
 #if defined( Q_OS_WIN ) && !defined( XMLUI_NO_STYLE_WINDOWS )
     setStyle( new XmlUi::WindowsStyle() );
 #elif defined( Q_OS_MAC ) && !defined( XMLUI_NO_STYLE_MAC )
@@ -52,13 +71,6 @@ FraqtiveApplication::FraqtiveApplication( int& argc, char** argv ) : QApplicatio
 
     setWindowIcon( IconLoader::icon( "fraqtive" ) ); 
 
-    registerDataStructures();
-
-    m_jobScheduler = new JobScheduler();
-
-    m_configuration = new ConfigurationData();
-    m_configuration->readConfiguration();
-
     m_mainWindow = new FraqtiveMainWindow();
     m_mainWindow->show();
 
@@ -76,12 +88,20 @@ FraqtiveApplication::~FraqtiveApplication()
     delete m_jobScheduler;
     m_jobScheduler = NULL;
 
-    m_configuration->writeConfiguration();
+    // the configuration is only read in batch mode so that it doesn't overwrite changes made in the GUI
+    if ( !m_batchMode )
+        m_configuration->writeConfiguration();
 
     delete m_configuration;
     m_configuration = NULL;
 }
 
+int FraqtiveApplication::renderBatch()
+{
+    BatchRenderer renderer( this );
+    return renderer.exec( arguments() );
+}
+
 QString FraqtiveApplication::version() const
 {
     return "0.4.8";
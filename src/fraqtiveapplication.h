@@ -32,7 +32,7 @@ class FraqtiveApplication : public QApplication
 {
     Q_OBJECT
 public:
-    FraqtiveApplication( int& argc, char** argv );
+    FraqtiveApplication( int& argc, char** argv, bool gui );
     ~FraqtiveApplication();
 
 public:
@@ -40,6 +40,8 @@ public:
 
     ConfigurationData* configuration() const { return m_configuration; }
 
+    int renderBatch();
+
 public slots:
     void about();
     void showQuickGuide();
@@ -55,6 +57,8 @@ private:
     ConfigurationData* m_configuration;
     FraqtiveMainWindow* m_mainWindow;
 
+    bool m_batchMode;
+
     QPointer<AboutBox> m_aboutBox;
     QPointer<GuideDialog> m_guideDialog;
 };
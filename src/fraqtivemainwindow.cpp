@@ -23,11 +23,8 @@
 #include <QImageWriter>
 #include <QClipboard>
 #include <QProgressDialog>
-#include <QPainter>
 #include <QMenu>
 
-#include <math.h>
-
 #include "datastructures.h"
 #include "fractalmodel.h"
 #include "fractalpresenter.h"
@@ -43,7 +40,10 @@
 #include "savepresetdialog.h"
 #include "generateimagedialog.h"
 #include "generateseriesdialog.h"
+#include "checkpoint.h"
 #include "imagegenerator.h"
+#include "seriesgenerator.h"
+#include "tiffwriter.h"
 #include "iconloader.h"
 #include "xmlui/toolstrip.h"
 #include "xmlui/builder.h"
@@ -385,7 +385,8 @@ void FraqtiveMainWindow::copyImage()
     QApplication::clipboard()->setImage( image );
 }
 
-QString FraqtiveMainWindow::getSaveFileName( const QString& title, const QString& fileName, QByteArray* selectedFormat, QFileDialog::Options options /*= 0*/ )
+QString FraqtiveMainWindow::getSaveFileName( const QString& title, const QString& fileName, QByteArray* selectedFormat, QFileDialog::Options options /*= 0*/,
+    const QByteArray& requiredFormat /*= QByteArray()*/, bool video /*= false*/ )
 {
     QList<QByteArray> supportedFormats = QImageWriter::supportedImageFormats();
 
@@ -401,13 +402,28 @@ QString FraqtiveMainWindow::getSaveFileName( const QString& title, const QString
         NULL
     };
 
+    // the required format is written directly, without an image plugin
     for ( int i = 0; data[ i ] != NULL; i += 3 ) {
-        if ( supportedFormats.contains( data[ i ] ) ) {
+        if ( requiredFormat.isEmpty() ? supportedFormats.contains( data[ i ] ) : requiredFormat == data[ i ] ) {
             formats.append( data[ i ] );
             filters.append( QString( "%1 (%2)" ).arg( tr( data[ i + 1 ] ), QString::fromLatin1( data[ i + 2 ] ) ) );
         }
     }
 
+    const char* videoData[] = {
+        "y4m", QT_TR_NOOP( "YUV4MPEG2 Video" ), "*.y4m",
+        "raw", QT_TR_NOOP( "Raw RGB Video" ), "*.raw",
+        NULL
+    };
+
+    // series can also be written as a single video stream
+    if ( video ) {
+        for ( int i = 0; videoData[ i ] != NULL; i += 3 ) {
+            formats.append( videoData[ i ] );
+            filters.append( QString( "%1 (%2)" ).arg( tr( videoData[ i + 1 ] ), QString::fromLatin1( videoData[ i + 2 ] ) ) );
+        }
+    }
+
     QByteArray format = *selectedFormat;
     if ( format.isEmpty() || !formats.contains( format ) )
         format = formats.first();
@@ -431,7 +447,7 @@ QString FraqtiveMainWindow::getSaveFileName( const QString& title, const QString
     return result;
 }
 
-QString FraqtiveMainWindow::getSaveImageName( QByteArray* selectedFormat )
+QString FraqtiveMainWindow::getSaveImageName( QByteArray* selectedFormat, bool streaming /*= false*/ )
 {
     ConfigurationData* config = fraqtive()->configuration();
 
@@ -440,10 +456,12 @@ QString FraqtiveMainWindow::getSaveImageName( QByteArray* selectedFormat )
     QString path = config->value( "SavePath", QDir::homePath() ).toString();
     QString fileName = QFileInfo( QDir( path ), tr( "fractal" ) ).absoluteFilePath();
 
-    QString result = getSaveFileName( tr( "Save Image" ), fileName, &format );
+    // large images can only be streamed to a TIFF file
+    QString result = getSaveFileName( tr( "Save Image" ), fileName, &format, 0, streaming ? "tiff" : QByteArray() );
 
     if ( !result.isEmpty() ) {
-        config->setValue( "SaveFormat", format );
+        if ( !streaming )
+            config->setValue( "SaveFormat", format );
         config->setValue( "SavePath", QFileInfo( result ).absolutePath() );
 
         *selectedFormat = format;
@@ -461,7 +479,7 @@ QString FraqtiveMainWindow::getSaveSeriesName( QByteArray* selectedFormat )
     QString path = config->value( "SeriesPath", QDir::homePath() ).toString();
     QString fileName = QFileInfo( QDir( path ), tr( "series" ) ).absoluteFilePath();
 
-    QString result = getSaveFileName( tr( "Save Series" ), fileName, &format, QFileDialog::DontConfirmOverwrite );
+    QString result = getSaveFileName( tr( "Save Series" ), fileName, &format, QFileDialog::DontConfirmOverwrite, QByteArray(), true );
 
     if ( !result.isEmpty() ) {
         config->setValue( "SeriesFormat", format );
@@ -497,20 +515,37 @@ void FraqtiveMainWindow::generateImage()
     GenerateImageDialog dialog( this );
 
     if ( dialog.exec() == QDialog::Accepted ) {
+        bool streaming = dialog.isStreaming();
+
         QByteArray format;
-        QString fileName = getSaveImageName( &format );
+        QString fileName = getSaveImageName( &format, streaming );
 
         if ( !fileName.isEmpty() ) {
+            // the writer and checkpoint must outlive the generator which is still using them
+            Checkpoint checkpoint( fileName );
+            TiffWriter tiffWriter( fileName );
+
             ImageGenerator generator( this );
-            generator.setResolution( dialog.resolution() * ( 1 << dialog.multiSampling() ) );
+            generator.setResolution( dialog.resolution() );
+            generator.setMultiSampling( dialog.multiSampling() );
+            generator.setAdaptiveSampling( dialog.adaptiveSampling() );
             generator.setParameters( m_model->fractalType(), m_model->position() );
             generator.setColorSettings( m_model->gradient(), m_model->backgroundColor(), m_model->colorMapping() );
             generator.setGeneratorSettings( dialog.generatorSettings() );
             generator.setViewSettings( dialog.viewSettings() );
 
+            bool resume = false;
+
+            if ( streaming ) {
+                generator.setCheckpoint( &checkpoint );
+
+                if ( generator.canResume() )
+                    resume = QMessageBox::question( this, tr( "Generate Image" ), tr( "Generating this image was interrupted. Do you want to continue from the last checkpoint?" ),
+                        QMessageBox::Yes | QMessageBox::No ) == QMessageBox::Yes;
+            }
+
             QProgressDialog progress( this );
             progress.setWindowModality( Qt::WindowModal );
-            progress.setRange( 0, generator.maximumProgress() );
             progress.setWindowTitle( tr( "Generate Image" ) );
             progress.setLabelText( tr( "Calculating..." ) );
             progress.setValue( 0 );
@@ -524,19 +559,30 @@ void FraqtiveMainWindow::generateImage()
             connect( &generator, SIGNAL( completed() ), &eventLoop, SLOT( quit() ), Qt::QueuedConnection );
             connect( &progress, SIGNAL( canceled() ), &eventLoop, SLOT( quit() ) );
 
-            if ( !generator.start() ) {
+            if ( streaming ) {
+                if ( !generator.startStreaming( &tiffWriter, resume ) ) {
+                    QMessageBox::warning( this, tr( "Error" ), tr( "The selected file could not be saved." ) );
+                    return;
+                }
+            } else if ( !generator.start() ) {
                 QMessageBox::warning( this, tr( "Error" ), tr( "Not enough memory to generate image." ) );
                 return;
             }
 
+            progress.setRange( 0, generator.maximumProgress() );
+
             eventLoop.exec();
 
-            if ( !progress.wasCanceled() ) {
+            if ( streaming ) {
+                if ( !progress.wasCanceled() ) {
+                    if ( tiffWriter.close() )
+                        checkpoint.remove();
+                    else
+                        QMessageBox::warning( this, tr( "Error" ), tr( "The selected file could not be saved." ) );
+                }
+            } else if ( !progress.wasCanceled() ) {
                 QImage image = generator.takeImage();
 
-                for ( int i = 0; i < dialog.multiSampling(); i++ )
-                    image = image.scaledToWidth( image.width() / 2, Qt::SmoothTransformation );
-
                 QImageWriter* writer = createImageWriter( fileName, format );
 
                 if ( !writer->write( image ) )
@@ -557,103 +603,59 @@ void FraqtiveMainWindow::generateSeries()
         QString fileName = getSaveSeriesName( &format );
 
         if ( !fileName.isEmpty() ) {
-            QFileInfo info( fileName );
-
-            ImageGenerator generator( this );
-            generator.setImageCount( dialog.images() );
-            generator.setResolution( dialog.resolution() * ( 1 << dialog.multiSampling() ) );
+            Checkpoint checkpoint( fileName );
 
+            SeriesGenerator generator( this );
+            generator.setResolution( dialog.resolution() );
+            generator.setMultiSampling( dialog.multiSampling(), dialog.adaptiveSampling() );
+            generator.setParameters( m_model->fractalType(), m_model->position() );
+            generator.setAnimation( dialog.images(), dialog.zoomFactor(), dialog.angle(), dialog.blending() );
+            generator.setExponentialMap( dialog.exponentialMap() );
             generator.setColorSettings( m_model->gradient(), m_model->backgroundColor(), m_model->colorMapping() );
             generator.setGeneratorSettings( dialog.generatorSettings() );
             generator.setViewSettings( dialog.viewSettings() );
+            generator.setOutput( fileName, format, dialog.encoder() );
+            generator.setCheckpoint( &checkpoint );
+
+            bool resume = false;
+
+            if ( generator.canResume() )
+                resume = QMessageBox::question( this, tr( "Generate Series" ), tr( "Generating this series was interrupted. Do you want to continue from the last checkpoint?" ),
+                    QMessageBox::Yes | QMessageBox::No ) == QMessageBox::Yes;
 
             QProgressDialog progress( this );
             progress.setWindowModality( Qt::WindowModal );
-            progress.setRange( 0, generator.maximumProgress() );
             progress.setWindowTitle( tr( "Generate Series" ) );
+            progress.setLabelText( tr( "Calculating %1 images..." ).arg( dialog.images() ) );
             progress.setValue( 0 );
 
             progress.setFixedHeight( progress.sizeHint().height() );
             progress.resize( 300, progress.height() );
 
-            connect( &generator, SIGNAL( progressChanged( int ) ), &progress, SLOT( setValue( int ) ), Qt::QueuedConnection );
-
-            QImage previous;
-
-            for ( int i = 0; i < dialog.images(); i++ ) {
-                progress.setLabelText( tr( "Calculating %1 of %2..." ).arg( i + 1 ).arg( dialog.images() ) );
-    
-                generator.setCurrentImage( i );
-
-                Position position = m_model->position();
-
-                double zoomTo = position.zoomFactor();
-                double zoomFrom = zoomTo - dialog.zoomFactor();
-                double angleTo = position.angle();
-                double angleFrom = angleTo - dialog.angle();
-
-                double a = (double)i / (double)( dialog.images() - 1 );
-
-                position.setZoomFactor( zoomFrom + a * ( zoomTo - zoomFrom ) );
-                position.setAngle( angleFrom + a * ( angleTo - angleFrom ) );
-
-                generator.setParameters( m_model->fractalType(), position );
-
-                QEventLoop eventLoop;
-
-                connect( &generator, SIGNAL( completed() ), &eventLoop, SLOT( quit() ), Qt::QueuedConnection );
-                connect( &progress, SIGNAL( canceled() ), &eventLoop, SLOT( quit() ) );
-
-                if ( !generator.start() ) {
-                    QMessageBox::warning( this, tr( "Error" ), tr( "Not enough memory to generate image." ) );
-                    return;
-                }
-
-                eventLoop.exec();
-
-                if ( progress.wasCanceled() )
-                    break;
-
-                QString fullName = info.completeBaseName() + QLatin1String( "." ) + QString::number( i ).rightJustified( 4, QLatin1Char( '0' ) ) + QLatin1String( "." ) + info.suffix();
-                QString fullPath = info.absoluteDir().absoluteFilePath( fullName );
-
-                QImage current = generator.takeImage();
-
-                if ( !previous.isNull() ) {
-                    QPainter painter( &current );
-
-                    double angle = ( angleTo - angleFrom ) / (double)( dialog.images() - 1 );
-                    double scale = pow( 10.0, ( zoomTo - zoomFrom ) / (double)( dialog.images() - 1 ) );
-
-                    QTransform transform;
-                    transform.translate( current.width() / 2, current.height() / 2 );
-                    transform.rotate( angle );
-                    transform.scale( scale, scale );
-                    transform.translate( -current.width() / 2, -current.height() / 2 );
-
-                    painter.setOpacity( dialog.blending() );
-                    painter.setTransform( transform );
-                    painter.setRenderHint( QPainter::SmoothPixmapTransform );
+            QEventLoop eventLoop;
 
-                    painter.drawImage( 0, 0, previous );
-                }
+            connect( &generator, SIGNAL( progressChanged( int ) ), &progress, SLOT( setValue( int ) ) );
+            connect( &generator, SIGNAL( completed() ), &eventLoop, SLOT( quit() ), Qt::QueuedConnection );
+            connect( &progress, SIGNAL( canceled() ), &eventLoop, SLOT( quit() ) );
 
-                if ( dialog.blending() > 0.01 )
-                    previous = current;
+            if ( !generator.start( resume ) ) {
+                QMessageBox::warning( this, tr( "Error" ), tr( "Not enough memory to generate image." ) );
+                return;
+            }
 
-                for ( int i = 0; i < dialog.multiSampling(); i++ )
-                    current = current.scaledToWidth( current.width() / 2, Qt::SmoothTransformation );
+            progress.setRange( 0, generator.maximumProgress() );
 
-                QImageWriter* writer = createImageWriter( fullPath, format );
+            eventLoop.exec();
 
-                if ( !writer->write( current ) ) {
-                    QMessageBox::warning( this, tr( "Error" ), tr( "The selected file could not be saved." ) );
-                    delete writer;
-                    break;
-                }
+            if ( progress.wasCanceled() )
+                generator.cancel();
 
-                delete writer;
-            }
+            if ( generator.error() == SeriesGenerator::MemoryError )
+                QMessageBox::warning( this, tr( "Error" ), tr( "Not enough memory to generate image." ) );
+            else if ( generator.error() == SeriesGenerator::FileError )
+                QMessageBox::warning( this, tr( "Error" ), tr( "The selected file could not be saved." ) );
+            else if ( !progress.wasCanceled() )
+                checkpoint.remove();
         }
     }
 }
@@ -71,8 +71,9 @@ private:
     void enterFullScreenMode();
     void leaveFullScreenMode();
 
-    QString getSaveFileName( const QString& title, const QString& fileName, QByteArray* selectedFormat, QFileDialog::Options options = 0 );
-    QString getSaveImageName( QByteArray* selectedFormat );
+    QString getSaveFileName( const QString& title, const QString& fileName, QByteArray* selectedFormat, QFileDialog::Options options = 0,
+        const QByteArray& requiredFormat = QByteArray(), bool video = false );
+    QString getSaveImageName( QByteArray* selectedFormat, bool streaming = false );
     QString getSaveSeriesName( QByteArray* selectedFormat );
 
     QImageWriter* createImageWriter( const QString& fileName, const QByteArray& format );
@@ -35,6 +35,8 @@ static void initializeDefaultSettings()
             config->setValue( "ImageResolution", QVariant::fromValue( QApplication::desktop()->screenGeometry().size() ) );
         if ( !config->contains( "ImageMultiSampling" ) )
             config->setValue( "ImageMultiSampling", QVariant::fromValue( 0 ) );
+        if ( !config->contains( "ImageAdaptiveSampling" ) )
+            config->setValue( "ImageAdaptiveSampling", QVariant::fromValue( false ) );
         if ( !config->contains( "ImageGeneratorSettings" ) )
             config->setValue( "ImageGeneratorSettings", QVariant::fromValue( DataFunctions::defaultGeneratorSettings() ) );
         if ( !config->contains( "ImageViewSettings" ) )
@@ -45,7 +47,8 @@ static void initializeDefaultSettings()
 }
 
 GenerateImageDialog::GenerateImageDialog( QWidget* parent ) : QDialog( parent ),
-    m_multiSampling( 0 )
+    m_multiSampling( 0 ),
+    m_adaptiveSampling( false )
 {
     m_ui.setupUi( this );
 
@@ -81,6 +84,10 @@ GenerateImageDialog::GenerateImageDialog( QWidget* parent ) : QDialog( parent ),
             break;
     }
 
+    m_adaptiveSampling = config->value( "ImageAdaptiveSampling" ).value<bool>();
+
+    m_ui.checkAdaptive->setChecked( m_adaptiveSampling );
+
     updateMaximumSize();
 
     m_resolution = config->value( "ImageResolution" ).value<QSize>();
@@ -91,6 +98,8 @@ GenerateImageDialog::GenerateImageDialog( QWidget* parent ) : QDialog( parent ),
     m_generatorSettings = config->value( "ImageGeneratorSettings" ).value<GeneratorSettings>();
 
     m_ui.sliderDepth->setScaledValue( m_generatorSettings.calculationDepth() );
+    m_ui.sliderDepth->setEnabled( !m_generatorSettings.automaticDepth() );
+    m_ui.checkAutoDepth->setChecked( m_generatorSettings.automaticDepth() );
     m_ui.sliderDetail->setScaledValue( m_generatorSettings.detailThreshold() );
 
     m_viewSettings = config->value( "ImageViewSettings" ).value<ViewSettings>();
@@ -115,27 +124,21 @@ GenerateImageDialog::~GenerateImageDialog()
 {
 }
 
-void GenerateImageDialog::on_radioMSNone_clicked()
+void GenerateImageDialog::on_checkAutoDepth_toggled()
 {
-    updateMaximumSize();
+    m_ui.sliderDepth->setEnabled( !m_ui.checkAutoDepth->isChecked() );
 }
 
-void GenerateImageDialog::on_radioMS2x2_clicked()
-{
-    updateMaximumSize();
-}
-
-void GenerateImageDialog::on_radioMS4x4_clicked()
-{
-    updateMaximumSize();
-}
+static const int MaximumStreamingSize = 131072;
 
-void GenerateImageDialog::on_radioMS8x8_clicked()
+void GenerateImageDialog::updateMaximumSize()
 {
-    updateMaximumSize();
+    // images which don't fit in memory are written to the file while they are generated
+    m_ui.spinWidth->setMaximum( MaximumStreamingSize );
+    m_ui.spinHeight->setMaximum( MaximumStreamingSize );
 }
 
-void GenerateImageDialog::updateMaximumSize()
+bool GenerateImageDialog::isStreaming() const
 {
     int width, height;
     if ( QSysInfo::WordSize == 64 ) {
@@ -146,16 +149,8 @@ void GenerateImageDialog::updateMaximumSize()
         height = 8000;
     }
 
-    int multiSampling = 0;
-    if ( m_ui.radioMS2x2->isChecked() )
-        multiSampling = 1;
-    else if ( m_ui.radioMS4x4->isChecked() )
-        multiSampling = 2;
-    else if ( m_ui.radioMS8x8->isChecked() )
-        multiSampling = 3;
-
-    m_ui.spinWidth->setMaximum( width >> multiSampling );
-    m_ui.spinHeight->setMaximum( height >> multiSampling );
+    // samples are downsampled while the image is generated, so only the final size matters
+    return m_resolution.width() > width || m_resolution.height() > height;
 }
 
 void GenerateImageDialog::accept()
@@ -177,7 +172,12 @@ void GenerateImageDialog::accept()
 
     config->setValue( "ImageMultiSampling", QVariant::fromValue( m_multiSampling ) );
 
+    m_adaptiveSampling = m_ui.checkAdaptive->isChecked();
+
+    config->setValue( "ImageAdaptiveSampling", QVariant::fromValue( m_adaptiveSampling ) );
+
     m_generatorSettings.setCalculationDepth( m_ui.sliderDepth->scaledValue() );
+    m_generatorSettings.setAutomaticDepth( m_ui.checkAutoDepth->isChecked() );
     m_generatorSettings.setDetailThreshold( m_ui.sliderDetail->scaledValue() );
 
     config->setValue( "ImageGeneratorSettings", QVariant::fromValue( m_generatorSettings ) );
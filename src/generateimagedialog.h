@@ -34,17 +34,17 @@ public:
 public:
     QSize resolution() const { return m_resolution; }
     int multiSampling() const { return m_multiSampling; }
+    bool adaptiveSampling() const { return m_adaptiveSampling; }
     GeneratorSettings generatorSettings() const { return m_generatorSettings; }
     ViewSettings viewSettings() const { return m_viewSettings; }
 
+    bool isStreaming() const;
+
 public: // overrides
     void accept();
 
 private slots:
-    void on_radioMSNone_clicked();
-    void on_radioMS2x2_clicked();
-    void on_radioMS4x4_clicked();
-    void on_radioMS8x8_clicked();
+    void on_checkAutoDepth_toggled();
 
 private:
     void updateMaximumSize();
@@ -54,6 +54,7 @@ private:
 
     QSize m_resolution;
     int m_multiSampling;
+    bool m_adaptiveSampling;
     GeneratorSettings m_generatorSettings;
     ViewSettings m_viewSettings;
 };
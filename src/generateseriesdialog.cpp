@@ -36,6 +36,8 @@ static void initializeSeriesSettings()
             config->setValue( "SeriesResolution", QVariant::fromValue( QSize( 640, 480 ) ) );
         if ( !config->contains( "SeriesMultiSampling" ) )
             config->setValue( "SeriesMultiSampling", QVariant::fromValue( 0 ) );
+        if ( !config->contains( "SeriesAdaptiveSampling" ) )
+            config->setValue( "SeriesAdaptiveSampling", QVariant::fromValue( false ) );
         if ( !config->contains( "SeriesGeneratorSettings" ) )
             config->setValue( "SeriesGeneratorSettings", QVariant::fromValue( DataFunctions::defaultGeneratorSettings() ) );
         if ( !config->contains( "SeriesViewSettings" ) )
@@ -44,6 +46,10 @@ static void initializeSeriesSettings()
             config->setValue( "SeriesImages", 100 );
         if ( !config->contains( "SeriesBlending" ) )
             config->setValue( "SeriesBlending", 0.0 );
+        if ( !config->contains( "SeriesExponentialMap" ) )
+            config->setValue( "SeriesExponentialMap", QVariant::fromValue( false ) );
+        if ( !config->contains( "SeriesEncoder" ) )
+            config->setValue( "SeriesEncoder", QString() );
 
         initialized = true;
     }
@@ -66,14 +72,14 @@ GenerateSeriesDialog::GenerateSeriesDialog( QWidget* parent, const FractalModel*
     m_ui.sliderDetail->setScaledRange( 3.0, 0.0 );
 
     int width = 0;
-    QLabel* labels[ 3 ] = { m_ui.labelZoom, m_ui.labelAngle, m_ui.labelBlending };
+    QLabel* labels[ 4 ] = { m_ui.labelZoom, m_ui.labelAngle, m_ui.labelBlending, m_ui.labelEncoder };
 
-    for ( int i = 0; i < 3; i++ )
+    for ( int i = 0; i < 4; i++ )
         width = qMax( width, labels[ i ]->sizeHint().width() );
 
     m_ui.imageSpacer->changeSize( width + m_ui.animationLayout->horizontalSpacing(), 20, QSizePolicy::Fixed, QSizePolicy::Expanding );
 
-    for ( int i = 0; i < 3; i++ )
+    for ( int i = 0; i < 4; i++ )
         labels[ i ]->setFixedWidth( width );
 
     initializeSeriesSettings();
@@ -97,6 +103,10 @@ GenerateSeriesDialog::GenerateSeriesDialog( QWidget* parent, const FractalModel*
             break;
     }
 
+    m_adaptiveSampling = config->value( "SeriesAdaptiveSampling" ).value<bool>();
+
+    m_ui.checkAdaptive->setChecked( m_adaptiveSampling );
+
     updateMaximumSize();
 
     m_resolution = config->value( "SeriesResolution" ).value<QSize>();
@@ -107,6 +117,8 @@ GenerateSeriesDialog::GenerateSeriesDialog( QWidget* parent, const FractalModel*
     m_generatorSettings = config->value( "SeriesGeneratorSettings" ).value<GeneratorSettings>();
 
     m_ui.sliderDepth->setScaledValue( m_generatorSettings.calculationDepth() );
+    m_ui.sliderDepth->setEnabled( !m_generatorSettings.automaticDepth() );
+    m_ui.checkAutoDepth->setChecked( m_generatorSettings.automaticDepth() );
     m_ui.sliderDetail->setScaledValue( m_generatorSettings.detailThreshold() );
 
     m_viewSettings = config->value( "SeriesViewSettings" ).value<ViewSettings>();
@@ -143,6 +155,14 @@ GenerateSeriesDialog::GenerateSeriesDialog( QWidget* parent, const FractalModel*
 
     m_ui.spinBlending->setValue( m_blending );
 
+    m_exponentialMap = config->value( "SeriesExponentialMap" ).toBool();
+
+    m_ui.checkExponentialMap->setChecked( m_exponentialMap );
+
+    m_encoder = config->value( "SeriesEncoder" ).toString();
+
+    m_ui.editEncoder->setText( m_encoder );
+
     m_presenter = new FractalPresenter( this );
 
     ImageView* view = new ImageView( m_ui.viewContainer, m_presenter );
@@ -182,6 +202,10 @@ void GenerateSeriesDialog::accept()
 
     config->setValue( "SeriesMultiSampling", QVariant::fromValue( m_multiSampling ) );
 
+    m_adaptiveSampling = m_ui.checkAdaptive->isChecked();
+
+    config->setValue( "SeriesAdaptiveSampling", QVariant::fromValue( m_adaptiveSampling ) );
+
     config->setValue( "SeriesGeneratorSettings", QVariant::fromValue( m_generatorSettings ) );
     config->setValue( "SeriesViewSettings", QVariant::fromValue( m_viewSettings ) );
 
@@ -196,6 +220,14 @@ void GenerateSeriesDialog::accept()
 
     config->setValue( "SeriesBlending", m_blending );
 
+    m_exponentialMap = m_ui.checkExponentialMap->isChecked();
+
+    config->setValue( "SeriesExponentialMap", QVariant::fromValue( m_exponentialMap ) );
+
+    m_encoder = m_ui.editEncoder->text().trimmed();
+
+    config->setValue( "SeriesEncoder", m_encoder );
+
     QDialog::accept();
 }
 
@@ -204,6 +236,12 @@ void GenerateSeriesDialog::on_sliderDepth_valueChanged()
     updateSettings();
 }
 
+void GenerateSeriesDialog::on_checkAutoDepth_toggled()
+{
+    m_ui.sliderDepth->setEnabled( !m_ui.checkAutoDepth->isChecked() );
+    updateSettings();
+}
+
 void GenerateSeriesDialog::on_sliderDetail_valueChanged()
 {
     updateSettings();
@@ -229,26 +267,6 @@ void GenerateSeriesDialog::on_radioAAHigh_clicked()
     updateSettings();
 }
 
-void GenerateSeriesDialog::on_radioMSNone_clicked()
-{
-    updateMaximumSize();
-}
-
-void GenerateSeriesDialog::on_radioMS2x2_clicked()
-{
-    updateMaximumSize();
-}
-
-void GenerateSeriesDialog::on_radioMS4x4_clicked()
-{
-    updateMaximumSize();
-}
-
-void GenerateSeriesDialog::on_radioMS8x8_clicked()
-{
-    updateMaximumSize();
-}
-
 void GenerateSeriesDialog::on_spinZoom_valueChanged()
 {
     updatePosition();
@@ -275,16 +293,9 @@ void GenerateSeriesDialog::updateMaximumSize()
         height = 8000;
     }
 
-    int multiSampling = 0;
-    if ( m_ui.radioMS2x2->isChecked() )
-        multiSampling = 1;
-    else if ( m_ui.radioMS4x4->isChecked() )
-        multiSampling = 2;
-    else if ( m_ui.radioMS8x8->isChecked() )
-        multiSampling = 3;
-
-    m_ui.spinWidth->setMaximum( width >> multiSampling );
-    m_ui.spinHeight->setMaximum( height >> multiSampling );
+    // samples are downsampled while the images are generated, so only the final size is limited
+    m_ui.spinWidth->setMaximum( width );
+    m_ui.spinHeight->setMaximum( height );
 }
 
 void GenerateSeriesDialog::updatePosition()
@@ -313,6 +324,7 @@ void GenerateSeriesDialog::updateSettings()
         return;
 
     m_generatorSettings.setCalculationDepth( m_ui.sliderDepth->scaledValue() );
+    m_generatorSettings.setAutomaticDepth( m_ui.checkAutoDepth->isChecked() );
     m_generatorSettings.setDetailThreshold( m_ui.sliderDetail->scaledValue() );
 
     if ( m_ui.radioAANone->isChecked() )
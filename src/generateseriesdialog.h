@@ -37,6 +37,7 @@ public:
 public:
     QSize resolution() const { return m_resolution; }
     int multiSampling() const { return m_multiSampling; }
+    bool adaptiveSampling() const { return m_adaptiveSampling; }
     GeneratorSettings generatorSettings() const { return m_generatorSettings; }
     ViewSettings viewSettings() const { return m_viewSettings; }
 
@@ -47,20 +48,21 @@ public:
 
     double blending() const { return m_blending; }
 
+    bool exponentialMap() const { return m_exponentialMap; }
+
+    QString encoder() const { return m_encoder; }
+
 public: // overrides
     void accept();
 
 private slots:
     void on_sliderDepth_valueChanged();
+    void on_checkAutoDepth_toggled();
     void on_sliderDetail_valueChanged();
     void on_radioAANone_clicked();
     void on_radioAALow_clicked();
     void on_radioAAMedium_clicked();
     void on_radioAAHigh_clicked();
-    void on_radioMSNone_clicked();
-    void on_radioMS2x2_clicked();
-    void on_radioMS4x4_clicked();
-    void on_radioMS8x8_clicked();
     void on_spinZoom_valueChanged();
     void on_spinAngle_valueChanged();
     void on_animSlider_valueChanged();
@@ -80,6 +82,7 @@ private:
 
     QSize m_resolution;
     int m_multiSampling;
+    bool m_adaptiveSampling;
     GeneratorSettings m_generatorSettings;
     ViewSettings m_viewSettings;
 
@@ -87,6 +90,10 @@ private:
     double m_zoomFactor;
     double m_angle;
     double m_blending;
+
+    bool m_exponentialMap;
+
+    QString m_encoder;
 };
 
 #endif
@@ -27,6 +27,10 @@
 # include <emmintrin.h>
 #endif
 
+#if defined( HAVE_AVX2 )
+# include <cpuid.h>
+#endif
+
 // see http://wiki.mimec.org/wiki/Fraqtive/Generator_Core for a description of this code
 
 namespace GeneratorCore
@@ -51,6 +55,16 @@ static inline double calculateResult( int maxIterations, int count, double final
     return sqrt( value );
 }
 
+static inline double calculateDistance( double final, double derivative )
+{
+    if ( derivative <= 0.0 )
+        return 0.0;
+
+    double radius = sqrt( final );
+
+    return 0.5 * radius * log( radius ) / derivative;
+}
+
 template<Variant VARIANT>
 static void adjust( double& /*zx*/, double& /*zy*/ );
 
@@ -79,15 +93,13 @@ inline void adjust<AbsoluteImVariant>( double& /*zx*/, double& zy )
 }
 
 template<Variant VARIANT>
-static inline double calculate( double x, double y, double cx, double cy, double exponent, int maxIterations )
+static inline double calculate( double& zx, double& zy, double cx, double cy, double exponent, int count, int maxIterations )
 {
-    double zx = x;
-    double zy = y;
     double radius;
 
     double exp2 = 0.5 * exponent;
 
-    for ( int k = maxIterations; k > 0; k-- ) {
+    for ( int k = count; k > 0; k-- ) {
         adjust<VARIANT>( zx, zy );
 
         double zxx = zx * zx;
@@ -112,6 +124,25 @@ static inline double calculate( double x, double y, double cx, double cy, double
 # pragma function( log, sqrt, exp, atan2, sin, cos, fabs )
 #endif
 
+static inline int remainingIterations( Sample* sample, double zx, double zy, int maxIterations )
+{
+    if ( sample->m_iterations == 0 ) {
+        sample->m_zx = zx;
+        sample->m_zy = zy;
+    }
+
+    return maxIterations - sample->m_iterations;
+}
+
+static inline double finishSample( Sample* sample, double zx, double zy, double result, int maxIterations )
+{
+    sample->m_zx = zx;
+    sample->m_zy = zy;
+    sample->m_iterations = ( result != 0.0 ) ? -1 : maxIterations;
+
+    return result;
+}
+
 class MandelbrotParams
 {
 public:
@@ -134,7 +165,18 @@ public:
 
     double operator()( double zx, double zy, int maxIterations )
     {
-        return calculate<VARIANT>( zx, zy, zx, zy, m_exponent, maxIterations );
+        double x = zx;
+        double y = zy;
+        return calculate<VARIANT>( x, y, zx, zy, m_exponent, maxIterations, maxIterations );
+    }
+
+    double resume( double zx, double zy, Sample* sample, int maxIterations )
+    {
+        int count = remainingIterations( sample, zx, zy, maxIterations );
+        double x = sample->m_zx;
+        double y = sample->m_zy;
+        double result = calculate<VARIANT>( x, y, zx, zy, m_exponent, count, maxIterations );
+        return finishSample( sample, x, y, result, maxIterations );
     }
 };
 
@@ -162,7 +204,16 @@ public:
 
     double operator()( double zx, double zy, int maxIterations )
     {
-        return calculate<VARIANT>( zx, zy, m_cx, m_cy, m_exponent, maxIterations );
+        return calculate<VARIANT>( zx, zy, m_cx, m_cy, m_exponent, maxIterations, maxIterations );
+    }
+
+    double resume( double zx, double zy, Sample* sample, int maxIterations )
+    {
+        int count = remainingIterations( sample, zx, zy, maxIterations );
+        double x = sample->m_zx;
+        double y = sample->m_zy;
+        double result = calculate<VARIANT>( x, y, m_cx, m_cy, m_exponent, count, maxIterations );
+        return finishSample( sample, x, y, result, maxIterations );
     }
 };
 
@@ -265,12 +316,9 @@ inline void calculatePower<1>( double& /*zx*/, double& /*zy*/, double& /*radius*
 }
 
 template<int N, Variant VARIANT>
-static double calculateFast( double x, double y, double cx, double cy, int maxIterations )
+static double calculateFast( double& zx, double& zy, double cx, double cy, int count, int maxIterations )
 {
-    double zx = x;
-    double zy = y;
-
-    for ( int k = maxIterations; k > 0; k-- ) {
+    for ( int k = count; k > 0; k-- ) {
         adjust<VARIANT>( zx, zy );
 
         double radius;
@@ -286,6 +334,57 @@ static double calculateFast( double x, double y, double cx, double cy, int maxIt
     return 0.0;
 }
 
+// N * |z|^(N-1) calculated from the squared radius
+template<int N>
+static inline double derivativeFactor( double radius )
+{
+    double factor = ( N % 2 == 0 ) ? sqrt( radius ) : 1.0;
+
+    for ( int i = 0; i < ( N - 1 ) / 2; i++ )
+        factor *= radius;
+
+    return N * factor;
+}
+
+// the estimate is only valid for holomorphic iterations and their conjugates;
+// the absolute variants fold the plane, so their distance is unknown
+template<Variant VARIANT>
+static inline bool hasDistanceEstimate()
+{
+    return VARIANT == NormalVariant || VARIANT == ConjugateVariant;
+}
+
+// dc is 1 for Mandelbrot and 0 for Julia
+template<int N, Variant VARIANT>
+static double calculateFastDistance( double& zx, double& zy, double& derivative, double cx, double cy, double dc,
+    int count, int maxIterations, double* distance )
+{
+    if ( !hasDistanceEstimate<VARIANT>() ) {
+        *distance = 0.0;
+        return calculateFast<N, VARIANT>( zx, zy, cx, cy, count, maxIterations );
+    }
+
+    for ( int k = count; k > 0; k-- ) {
+        adjust<VARIANT>( zx, zy );
+
+        double radius;
+        calculatePower<N>( zx, zy, radius );
+
+        if ( radius >= BailoutRadius ) {
+            *distance = calculateDistance( radius, derivative );
+            return calculateResult( maxIterations, k, radius, N );
+        }
+
+        derivative = derivativeFactor<N>( radius ) * derivative + dc;
+
+        zx += cx;
+        zy += cy;
+    }
+
+    *distance = 0.0;
+    return 0.0;
+}
+
 class MandelbrotFastParams
 {
 public:
@@ -304,7 +403,26 @@ public:
 
     double operator()( double zx, double zy, int maxIterations )
     {
-        return calculateFast<N, VARIANT>( zx, zy, zx, zy, maxIterations );
+        double x = zx;
+        double y = zy;
+        return calculateFast<N, VARIANT>( x, y, zx, zy, maxIterations, maxIterations );
+    }
+
+    double resume( double zx, double zy, Sample* sample, int maxIterations )
+    {
+        int count = remainingIterations( sample, zx, zy, maxIterations );
+        double x = sample->m_zx;
+        double y = sample->m_zy;
+        double result = calculateFast<N, VARIANT>( x, y, zx, zy, count, maxIterations );
+        return finishSample( sample, x, y, result, maxIterations );
+    }
+
+    double estimate( double zx, double zy, int maxIterations, double* distance )
+    {
+        double x = zx;
+        double y = zy;
+        double derivative = 1.0;
+        return calculateFastDistance<N, VARIANT>( x, y, derivative, zx, zy, 1.0, maxIterations, maxIterations, distance );
     }
 };
 
@@ -332,9 +450,23 @@ public:
 
     double operator()( double zx, double zy, int maxIterations )
     {
-        return calculateFast<N, VARIANT>( zx, zy, m_cx, m_cy, maxIterations );
+        return calculateFast<N, VARIANT>( zx, zy, m_cx, m_cy, maxIterations, maxIterations );
+    }
+
+    double resume( double zx, double zy, Sample* sample, int maxIterations )
+    {
+        int count = remainingIterations( sample, zx, zy, maxIterations );
+        double x = sample->m_zx;
+        double y = sample->m_zy;
+        double result = calculateFast<N, VARIANT>( x, y, m_cx, m_cy, count, maxIterations );
+        return finishSample( sample, x, y, result, maxIterations );
     }
 
+    double estimate( double zx, double zy, int maxIterations, double* distance )
+    {
+        double derivative = 1.0;
+        return calculateFastDistance<N, VARIANT>( zx, zy, derivative, m_cx, m_cy, 0.0, maxIterations, maxIterations, distance );
+    }
 };
 
 template<typename BASE, template<int N, Variant VARIANT> class FACTORY, int EXPONENT = MaxExponent>
@@ -406,18 +538,87 @@ Functor* createJuliaFastFunctor( double cx, double cy, int exponent, Variant var
     return FastFunctorFactory<Functor, JuliaFastFunctor>::create( exponent, variant, JuliaFastParams( cx, cy ) );
 }
 
-void generatePreview( const Input& input, const Output& output, Functor* functor, int maxIterations )
+static inline double pixelScale( const Input& input )
+{
+    return 1.0 / sqrt( input.m_ca * input.m_ca + input.m_sa * input.m_sa );
+}
+
+// returns false if the point was already calculated by a previous pass
+static inline bool markCalculated( unsigned char* flags, int offset )
+{
+    if ( flags == NULL )
+        return true;
+
+    if ( flags[ offset ] != 0 )
+        return false;
+
+    flags[ offset ] = 1;
+    return true;
+}
+
+class PointCalculator
+{
+public:
+    PointCalculator( const Input& input, const Output& output, Functor* functor, int maxIterations, double* distances,
+        unsigned char* flags = NULL ) :
+        m_buffer( output.m_buffer ),
+        m_distances( distances ),
+        m_flags( flags ),
+        m_functor( functor ),
+        m_maxIterations( maxIterations ),
+        m_scale( pixelScale( input ) )
+    {
+    }
+
+    void operator()( int offset, double zx, double zy )
+    {
+        if ( markCalculated( m_flags, offset ) )
+            m_buffer[ offset ] = ( *m_functor )( zx, zy, m_maxIterations );
+    }
+
+    void estimate( int offset, double zx, double zy )
+    {
+        if ( m_distances ) {
+            double distance;
+            m_buffer[ offset ] = m_functor->estimate( zx, zy, m_maxIterations, &distance );
+            m_distances[ offset ] = distance * m_scale;
+        } else {
+            m_buffer[ offset ] = ( *m_functor )( zx, zy, m_maxIterations );
+        }
+    }
+
+    double distance( int offset ) const
+    {
+        return m_distances ? m_distances[ offset ] : 0.0;
+    }
+
+private:
+    double* m_buffer;
+    double* m_distances;
+    unsigned char* m_flags;
+    Functor* m_functor;
+    int m_maxIterations;
+    double m_scale;
+};
+
+template<typename CALCULATOR>
+static void calculatePreview( const Input& input, const Output& output, CALCULATOR& calculator )
 {
     for ( int y = 0; y < output.m_height; y += CellSize ) {
-        double* row = output.m_buffer + output.m_stride * y;
         for ( int x = 0; x < output.m_width; x += CellSize ) {
             double zx = input.m_x + input.m_ca * x + input.m_sa * y;
             double zy = input.m_y - input.m_sa * x + input.m_ca * y;
-            row[ x ] = ( *functor )( zx, zy, maxIterations );
+            calculator.estimate( output.m_stride * y + x, zx, zy );
         }
     }
 }
 
+void generatePreview( const Input& input, const Output& output, Functor* functor, int maxIterations, double* distances )
+{
+    PointCalculator calculator( input, output, functor, maxIterations, distances );
+    calculatePreview( input, output, calculator );
+}
+
 static inline bool checkThreshold( double p1, double p2, double threshold )
 {
     double pmin, pmax;
@@ -435,26 +636,54 @@ static inline bool checkThreshold( double p1, double p2, double threshold )
     return false;
 }
 
-static inline bool checkThreshold( double p1, double p2, double p3, double p4, double threshold )
+static const double BoundaryRange = 0.25;
+static const double DistanceRange = 2.0;
+
+// the real distance is between the estimate and four times the estimate
+static inline bool checkThreshold( double p1, double p2, double d1, double d2, double span, double threshold )
+{
+    if ( d1 > 0.0 && d2 > 0.0 ) {
+        double distance = qMin( d1, d2 );
+
+        // thin filaments may pass between the points even if their values are similar
+        if ( distance <= BoundaryRange * span )
+            return true;
+
+        // the cell is covered by a disk which contains no boundary
+        if ( distance > DistanceRange * span )
+            return false;
+    }
+
+    return checkThreshold( p1, p2, threshold );
+}
+
+static inline bool checkThreshold( double p1, double p2, double p3, double p4,
+    double d1, double d2, double d3, double d4, double threshold )
 {
-    return checkThreshold( p1, p2, threshold )
-        || checkThreshold( p3, p4, threshold )
-        || checkThreshold( p1, p3, threshold )
-        || checkThreshold( p2, p4, threshold );
+    // the whole cell must be covered, not only its edges
+    double span = sqrt( 2.0 ) * CellSize;
+
+    return checkThreshold( p1, p2, d1, d2, span, threshold )
+        || checkThreshold( p3, p4, d3, d4, span, threshold )
+        || checkThreshold( p1, p3, d1, d3, span, threshold )
+        || checkThreshold( p2, p4, d2, d4, span, threshold );
 }
 
-void generateDetails( const Input& input, const Output& output, Functor* functor, int maxIterations, double threshold )
+template<typename CALCULATOR>
+static void calculateDetails( const Input& input, const Output& output, CALCULATOR& calculator, double threshold )
 {
     for ( int y = 0; y < output.m_height; y += CellSize ) {
         double* row = output.m_buffer + output.m_stride * y;
         for ( int x = 0; x < output.m_width - CellSize; x += CellSize ) {
             double p1 = row[ x ];
             double p2 = row[ x + CellSize ];
-            if ( checkThreshold( p1, p2, threshold ) ) {
+            double d1 = calculator.distance( output.m_stride * y + x );
+            double d2 = calculator.distance( output.m_stride * y + x + CellSize );
+            if ( checkThreshold( p1, p2, d1, d2, CellSize, threshold ) ) {
                 for ( int i = 1; i < CellSize; i++ ) {
                     double zx = input.m_x + input.m_ca * ( x + i ) + input.m_sa * y;
                     double zy = input.m_y - input.m_sa * ( x + i ) + input.m_ca * y;
-                    row[ x + i ] = ( *functor )( zx, zy, maxIterations );
+                    calculator( output.m_stride * y + x + i, zx, zy );
                 }
             }
         }
@@ -465,11 +694,13 @@ void generateDetails( const Input& input, const Output& output, Functor* functor
         for ( int x = 0; x < output.m_width; x += CellSize ) {
             double p1 = row[ x ];
             double p2 = row[ output.m_stride * CellSize + x ];
-            if ( checkThreshold( p1, p2, threshold ) ) {
+            double d1 = calculator.distance( output.m_stride * y + x );
+            double d2 = calculator.distance( output.m_stride * ( y + CellSize ) + x );
+            if ( checkThreshold( p1, p2, d1, d2, CellSize, threshold ) ) {
                 for ( int i = 1; i < CellSize; i++ ) {
                     double zx = input.m_x + input.m_ca * x + input.m_sa * ( y + i );
                     double zy = input.m_y - input.m_sa * x + input.m_ca * ( y + i );
-                    row[ output.m_stride * i + x ] = ( *functor )( zx, zy, maxIterations );
+                    calculator( output.m_stride * ( y + i ) + x, zx, zy );
                 }
             }
         }
@@ -482,12 +713,16 @@ void generateDetails( const Input& input, const Output& output, Functor* functor
             double p2 = row[ x + CellSize ];
             double p3 = row[ output.m_stride * CellSize + x ];
             double p4 = row[ output.m_stride * CellSize + x + CellSize ];
-            if ( checkThreshold( p1, p2, p3, p4, threshold ) ) {
+            double d1 = calculator.distance( output.m_stride * y + x );
+            double d2 = calculator.distance( output.m_stride * y + x + CellSize );
+            double d3 = calculator.distance( output.m_stride * ( y + CellSize ) + x );
+            double d4 = calculator.distance( output.m_stride * ( y + CellSize ) + x + CellSize );
+            if ( checkThreshold( p1, p2, p3, p4, d1, d2, d3, d4, threshold ) ) {
                 for ( int i = 1; i < CellSize; i++ ) {
                     for ( int j = 1; j < CellSize; j++ ) {
                         double zx = input.m_x + input.m_ca * ( x + j ) + input.m_sa * ( y + i );
                         double zy = input.m_y - input.m_sa * ( x + j ) + input.m_ca * ( y + i );
-                        row[ output.m_stride * i + x + j ] = ( *functor )( zx, zy, maxIterations );
+                        calculator( output.m_stride * ( y + i ) + x + j, zx, zy );
                     }
                 }
             }
@@ -495,15 +730,30 @@ void generateDetails( const Input& input, const Output& output, Functor* functor
     }
 }
 
-void interpolate( const Output& output )
+void generateDetails( const Input& input, const Output& output, Functor* functor, int maxIterations, double threshold,
+    double* distances, unsigned char* flags )
 {
+    PointCalculator calculator( input, output, functor, maxIterations, distances, flags );
+    calculateDetails( input, output, calculator, threshold );
+}
+
+static inline bool isInterpolated( const unsigned char* flags, int offset )
+{
+    return flags == NULL || flags[ offset ] == 0;
+}
+
+void interpolate( const Output& output, const unsigned char* flags )
+{
+    // calculated points are more accurate than interpolated values
     for ( int y = 0; y < output.m_height; y += CellSize ) {
         double* row = output.m_buffer + output.m_stride * y;
         for ( int x = 0; x < output.m_width - CellSize; x += CellSize ) {
             double p1 = row[ x ];
             double p2 = row[ x + CellSize ];
-            for ( int i = 1; i < CellSize; i++ )
-                row[ x + i ] = (double)( CellSize - i ) / (double)CellSize * p1 + (double)i / (double)CellSize * p2;
+            for ( int i = 1; i < CellSize; i++ ) {
+                if ( isInterpolated( flags, output.m_stride * y + x + i ) )
+                    row[ x + i ] = (double)( CellSize - i ) / (double)CellSize * p1 + (double)i / (double)CellSize * p2;
+            }
         }
     }
     for ( int y = 0; y < output.m_height - CellSize; y += CellSize ) {
@@ -511,12 +761,132 @@ void interpolate( const Output& output )
         for ( int x = 0; x < output.m_width; x++ ) {
             double p1 = row[ x ];
             double p2 = row[ output.m_stride * CellSize + x ];
-            for ( int i = 1; i < CellSize; i++ )
-                row[ output.m_stride * i + x ] = (double)( CellSize - i ) / (double)CellSize * p1 + (double)i / (double)CellSize * p2;
+            for ( int i = 1; i < CellSize; i++ ) {
+                if ( isInterpolated( flags, output.m_stride * ( y + i ) + x ) )
+                    row[ output.m_stride * i + x ] = (double)( CellSize - i ) / (double)CellSize * p1 + (double)i / (double)CellSize * p2;
+            }
         }
     }
 }
 
+void generatePoints( const Input& input, double* row, int y, const int* columns, int count, Functor* functor, int maxIterations )
+{
+    for ( int i = 0; i < count; i++ ) {
+        int x = columns[ i ];
+        double zx = input.m_x + input.m_ca * x + input.m_sa * y;
+        double zy = input.m_y - input.m_sa * x + input.m_ca * y;
+        row[ x ] = ( *functor )( zx, zy, maxIterations );
+    }
+}
+
+void generatePoints( const double* zx, const double* zy, double* result, int count, Functor* functor, int maxIterations )
+{
+    for ( int i = 0; i < count; i++ )
+        result[ i ] = ( *functor )( zx[ i ], zy[ i ], maxIterations );
+}
+
+static inline bool isCalculated( const unsigned char* flags, int x, int y, int offset )
+{
+    // grid points are always calculated
+    return ( x % CellSize == 0 && y % CellSize == 0 ) || flags[ offset ] != 0;
+}
+
+void resumeSamples( const Input& input, const Output& output, const unsigned char* flags, QVector<Sample>* samples,
+    Functor* functor, int maxIterations )
+{
+    QVector<Sample> remaining;
+
+    const Sample* stored = samples->constData();
+    const Sample* end = stored + samples->count();
+
+    for ( int y = 0; y < output.m_height; y++ ) {
+        double* row = output.m_buffer + output.m_stride * y;
+        for ( int x = 0; x < output.m_width; x++ ) {
+            int offset = output.m_stride * y + x;
+
+            // escaped points are final
+            if ( row[ x ] != 0.0 || !isCalculated( flags, x, y, offset ) )
+                continue;
+
+            Sample sample;
+            if ( stored != end && stored->m_offset == offset ) {
+                sample = *stored++;
+            } else {
+                sample.m_iterations = 0;
+                sample.m_offset = offset;
+            }
+
+            if ( sample.m_iterations < maxIterations ) {
+                double zx = input.m_x + input.m_ca * x + input.m_sa * y;
+                double zy = input.m_y - input.m_sa * x + input.m_ca * y;
+                row[ x ] = functor->resume( zx, zy, &sample, maxIterations );
+            }
+
+            if ( sample.m_iterations > 0 )
+                remaining.append( sample );
+        }
+    }
+
+    *samples = remaining;
+}
+
+int probeIterations( const Input& input, int width, int height, Functor* functor, int minIterations, int maxIterations,
+    double tolerance, int histogram[] )
+{
+    for ( int i = 0; i < HistogramSize; i++ )
+        histogram[ i ] = 0;
+
+    int count = width * height;
+    Sample* samples = new Sample[ count ];
+
+    for ( int i = 0; i < count; i++ )
+        samples[ i ].m_iterations = 0;
+
+    int limit = minIterations;
+    int previous = 0;
+    int total = 0;
+
+    for ( ;; ) {
+        int escaped = 0;
+
+        for ( int y = 0; y < height; y++ ) {
+            for ( int x = 0; x < width; x++ ) {
+                Sample* sample = samples + y * width + x;
+                if ( sample->m_iterations < 0 )
+                    continue;
+
+                double zx = input.m_x + input.m_ca * x + input.m_sa * y;
+                double zy = input.m_y - input.m_sa * x + input.m_ca * y;
+                double value = functor->resume( zx, zy, sample, limit );
+
+                if ( value != 0.0 ) {
+                    int bucket = (int)( log( qMax( value * value, 1.0 ) ) / log( 2.0 ) );
+                    histogram[ qMin( bucket, HistogramSize - 1 ) ]++;
+                    escaped++;
+                }
+            }
+        }
+
+        total += escaped;
+
+        // the previous limit is enough if few points escaped after it
+        if ( previous > 0 && total > 0 && escaped <= tolerance * count ) {
+            limit = previous;
+            break;
+        }
+
+        if ( limit >= maxIterations )
+            break;
+
+        previous = limit;
+        limit = qMin( limit * 4, maxIterations );
+    }
+
+    delete[] samples;
+
+    return limit;
+}
+
 #if defined( HAVE_SSE2 )
 
 #if defined( Q_CC_MSVC )
@@ -608,6 +978,39 @@ bool isSSE2Available()
     return AvailableCPUFeatures & SSE2;
 }
 
+#if defined( HAVE_AVX2 )
+
+static bool detectAVX2()
+{
+    unsigned int eax, ebx, ecx, edx;
+    if ( !__get_cpuid( 1, &eax, &ebx, &ecx, &edx ) )
+        return false;
+
+    // the AVX registers must be saved by the operating system
+    if ( !( ecx & ( 1 << 27 ) ) || !( ecx & ( 1 << 28 ) ) )
+        return false;
+
+    unsigned int xcr0;
+    asm( ".byte 0x0f, 0x01, 0xd0" : "=a" ( xcr0 ) : "c" ( 0 ) : "%edx" );
+    if ( ( xcr0 & 6 ) != 6 )
+        return false;
+
+    if ( __get_cpuid_max( 0, NULL ) < 7 )
+        return false;
+
+    __cpuid_count( 7, 0, eax, ebx, ecx, edx );
+    return ( ebx & ( 1 << 5 ) ) != 0;
+}
+
+static const bool AVX2Available = detectAVX2();
+
+bool isAVX2Available()
+{
+    return AVX2Available;
+}
+
+#endif // defined( HAVE_AVX2 )
+
 template<int N>
 static inline void calculatePowerSSE2( __m128d& zx, __m128d& zy, __m128d& radius )
 {
@@ -775,6 +1178,85 @@ static inline void calculateSSE2( double result[], double x[], double y[], doubl
     result[ 1 ] = count[ 1 ] ? calculateResult( maxIterations, count[ 1 ], final[ 1 ], N ) : 0.0;
 }
 
+template<int N>
+static inline __m128d derivativeFactorSSE2( __m128d radius )
+{
+    __m128d factor = ( N % 2 == 0 ) ? _mm_sqrt_pd( radius ) : _mm_set1_pd( 1.0 );
+
+    for ( int i = 0; i < ( N - 1 ) / 2; i++ )
+        factor = _mm_mul_pd( factor, radius );
+
+    return _mm_mul_pd( factor, _mm_set1_pd( N ) );
+}
+
+// same as calculateSSE2() but also tracks the derivative; steps are not repeated
+// because this is only used for the grid points
+template<int N, Variant VARIANT>
+static inline void calculateDistanceSSE2( double result[], double distance[], double x[], double y[], double cx[], double cy[],
+    double dc, int maxIterations )
+{
+    if ( !hasDistanceEstimate<VARIANT>() ) {
+        calculateSSE2<N, VARIANT>( result, x, y, cx, cy, maxIterations );
+        distance[ 0 ] = 0.0;
+        distance[ 1 ] = 0.0;
+        return;
+    }
+
+    __m128d zx = _mm_load_pd( x );
+    __m128d zy = _mm_load_pd( y );
+
+    __m128d rcx = _mm_load_pd( cx );
+    __m128d rcy = _mm_load_pd( cy ); 
+
+    __m128d rmax = _mm_set1_pd( BailoutRadius ); 
+
+    __m128d derivative = _mm_set1_pd( 1.0 );
+    __m128d rdc = _mm_set1_pd( dc );
+
+    int count[ 2 ] = { 0, 0 };
+    double final[ 2 ] = { 0.0, 0.0 };
+    double finalDerivative[ 2 ] = { 0.0, 0.0 };
+
+    for ( int k = maxIterations; k > 0; k-- ) {
+        adjustSSE2<VARIANT>( zx, zy );
+
+        __m128d radius;
+        calculatePowerSSE2<N>( zx, zy, radius );
+
+        int mask = _mm_movemask_pd( _mm_cmpge_pd( radius, rmax ) );
+
+        zx = _mm_add_pd( zx, rcx );
+        zy = _mm_add_pd( zy, rcy );
+
+        if ( mask ) {
+            if ( ( mask & 1 ) && !count[ 0 ] ) {
+                count[ 0 ] = k;
+                _mm_storel_pd( &final[ 0 ], radius );
+                _mm_storel_pd( &finalDerivative[ 0 ], derivative );
+            }
+            if ( ( mask & 2 ) && !count[ 1 ] ) {
+                count[ 1 ] = k;
+                _mm_storeh_pd( &final[ 1 ], radius );
+                _mm_storeh_pd( &finalDerivative[ 1 ], derivative );
+            }
+            if ( count[ 0 ] && count[ 1 ] )
+                break;
+        }
+
+        derivative = _mm_add_pd( _mm_mul_pd( derivativeFactorSSE2<N>( radius ), derivative ), rdc );
+    }
+
+    for ( int i = 0; i < 2; i++ ) {
+        if ( count[ i ] ) {
+            result[ i ] = calculateResult( maxIterations, count[ i ], final[ i ], N );
+            distance[ i ] = calculateDistance( final[ i ], finalDerivative[ i ] );
+        } else {
+            result[ i ] = 0.0;
+            distance[ i ] = 0.0;
+        }
+    }
+}
+
 template<int N, Variant VARIANT>
 class MandelbrotFunctorSSE2 : public FunctorSSE2, public MandelbrotFastParams
 {
@@ -787,6 +1269,11 @@ public:
     {
         calculateSSE2<N, VARIANT>( result, zx, zy, zx, zy, maxIterations );
     }
+
+    void estimate( double result[], double distance[], double zx[], double zy[], int maxIterations )
+    {
+        calculateDistanceSSE2<N, VARIANT>( result, distance, zx, zy, zx, zy, 1.0, maxIterations );
+    }
 };
 
 template<int N, Variant VARIANT>
@@ -803,6 +1290,13 @@ public:
         ALIGNXMM( double cy[ 2 ] ) = { m_cy, m_cy };
         calculateSSE2<N, VARIANT>( result, zx, zy, cx, cy, maxIterations );
     }
+
+    void estimate( double result[], double distance[], double zx[], double zy[], int maxIterations )
+    {
+        ALIGNXMM( double cx[ 2 ] ) = { m_cx, m_cx };
+        ALIGNXMM( double cy[ 2 ] ) = { m_cy, m_cy };
+        calculateDistanceSSE2<N, VARIANT>( result, distance, zx, zy, cx, cy, 0.0, maxIterations );
+    }
 };
 
 FunctorSSE2* createMandelbrotFunctorSSE2( int exponent, Variant variant )
@@ -815,12 +1309,15 @@ FunctorSSE2* createJuliaFunctorSSE2( double cx, double cy, int exponent, Variant
     return FastFunctorFactory<FunctorSSE2, JuliaFunctorSSE2>::create( exponent, variant, JuliaFastParams( cx, cy ) );
 }
 
-void generatePreviewSSE2( const Input& input, const Output& output, FunctorSSE2* functor, int maxIterations )
+void generatePreviewSSE2( const Input& input, const Output& output, FunctorSSE2* functor, int maxIterations, double* distances )
 {
     ALIGNXMM( double zx[ 2 ] );
     ALIGNXMM( double zy[ 2 ] );
 
     double result[ 2 ];
+    double distance[ 2 ];
+
+    double scale = pixelScale( input );
 
     for ( int y = 0; y < output.m_height; y += CellSize ) {
         double* row = output.m_buffer + output.m_stride * y;
@@ -829,7 +1326,15 @@ void generatePreviewSSE2( const Input& input, const Output& output, FunctorSSE2*
             zx[ 1 ] = zx[ 0 ] + input.m_ca * CellSize;
             zy[ 0 ] = input.m_y - input.m_sa * x + input.m_ca * y;
             zy[ 1 ] = zy[ 0 ] - input.m_sa * CellSize;
-            ( *functor )( result, zx, zy, maxIterations );
+            if ( distances ) {
+                functor->estimate( result, distance, zx, zy, maxIterations );
+                double* distanceRow = distances + output.m_stride * y;
+                distanceRow[ x ] = distance[ 0 ] * scale;
+                if ( x + CellSize < output.m_width )
+                    distanceRow[ x + CellSize ] = distance[ 1 ] * scale;
+            } else {
+                ( *functor )( result, zx, zy, maxIterations );
+            }
             row[ x ] = result[ 0 ];
             if ( x + CellSize < output.m_width )
                 row[ x + CellSize ] = result[ 1 ];
@@ -837,7 +1342,13 @@ void generatePreviewSSE2( const Input& input, const Output& output, FunctorSSE2*
     }
 }
 
-void generateDetailsSSE2( const Input& input, const Output& output, FunctorSSE2* functor, int maxIterations, double threshold )
+static inline double distanceAt( const double* distances, int offset )
+{
+    return distances ? distances[ offset ] : 0.0;
+}
+
+void generateDetailsSSE2( const Input& input, const Output& output, FunctorSSE2* functor, int maxIterations, double threshold,
+    double* distances, unsigned char* flags )
 {
     ALIGNXMM( double zx[ 2 ] );
     ALIGNXMM( double zy[ 2 ] );
@@ -849,8 +1360,15 @@ void generateDetailsSSE2( const Input& input, const Output& output, FunctorSSE2*
         for ( int x = 0; x < output.m_width - CellSize; x += CellSize ) {
             double p1 = row[ x ];
             double p2 = row[ x + CellSize ];
-            if ( checkThreshold( p1, p2, threshold ) ) {
+            double d1 = distanceAt( distances, output.m_stride * y + x );
+            double d2 = distanceAt( distances, output.m_stride * y + x + CellSize );
+            if ( checkThreshold( p1, p2, d1, d2, CellSize, threshold ) ) {
                 for ( int i = 1; i < CellSize; i += 2 ) {
+                    // both points of the pair belong to the same edge
+                    if ( !markCalculated( flags, output.m_stride * y + x + i ) )
+                        continue;
+                    if ( i + 1 < CellSize )
+                        markCalculated( flags, output.m_stride * y + x + i + 1 );
                     zx[ 0 ] = input.m_x + input.m_ca * ( x + i ) + input.m_sa * y;
                     zx[ 1 ] = zx[ 0 ] + input.m_ca;
                     zy[ 0 ] = input.m_y - input.m_sa * ( x + i ) + input.m_ca * y;
@@ -869,8 +1387,14 @@ void generateDetailsSSE2( const Input& input, const Output& output, FunctorSSE2*
         for ( int x = 0; x < output.m_width; x += CellSize ) {
             double p1 = row[ x ];
             double p2 = row[ output.m_stride * CellSize + x ];
-            if ( checkThreshold( p1, p2, threshold ) ) {
+            double d1 = distanceAt( distances, output.m_stride * y + x );
+            double d2 = distanceAt( distances, output.m_stride * ( y + CellSize ) + x );
+            if ( checkThreshold( p1, p2, d1, d2, CellSize, threshold ) ) {
                 for ( int i = 1; i < CellSize; i += 2 ) {
+                    if ( !markCalculated( flags, output.m_stride * ( y + i ) + x ) )
+                        continue;
+                    if ( i + 1 < CellSize )
+                        markCalculated( flags, output.m_stride * ( y + i + 1 ) + x );
                     zx[ 0 ] = input.m_x + input.m_ca * x + input.m_sa * ( y + i );
                     zx[ 1 ] = zx[ 0 ] + input.m_sa;
                     zy[ 0 ] = input.m_y - input.m_sa * x + input.m_ca * ( y + i );
@@ -891,9 +1415,17 @@ void generateDetailsSSE2( const Input& input, const Output& output, FunctorSSE2*
             double p2 = row[ x + CellSize ];
             double p3 = row[ output.m_stride * CellSize + x ];
             double p4 = row[ output.m_stride * CellSize + x + CellSize ];
-            if ( checkThreshold( p1, p2, p3, p4, threshold ) ) {
+            double d1 = distanceAt( distances, output.m_stride * y + x );
+            double d2 = distanceAt( distances, output.m_stride * y + x + CellSize );
+            double d3 = distanceAt( distances, output.m_stride * ( y + CellSize ) + x );
+            double d4 = distanceAt( distances, output.m_stride * ( y + CellSize ) + x + CellSize );
+            if ( checkThreshold( p1, p2, p3, p4, d1, d2, d3, d4, threshold ) ) {
                 for ( int i = 1; i < CellSize; i++ ) {
                     for ( int j = 1; j < CellSize; j += 2 ) {
+                        if ( !markCalculated( flags, output.m_stride * ( y + i ) + x + j ) )
+                            continue;
+                        if ( j + 1 < CellSize )
+                            markCalculated( flags, output.m_stride * ( y + i ) + x + j + 1 );
                         zx[ 0 ] = input.m_x + input.m_ca * ( x + j ) + input.m_sa * ( y + i );
                         zx[ 1 ] = zx[ 0 ] + input.m_ca;
                         zy[ 0 ] = input.m_y - input.m_sa * ( x + j ) + input.m_ca * ( y + i );
@@ -909,6 +1441,47 @@ void generateDetailsSSE2( const Input& input, const Output& output, FunctorSSE2*
     }
 }
 
+void generatePointsSSE2( const Input& input, double* row, int y, const int* columns, int count, FunctorSSE2* functor, int maxIterations )
+{
+    ALIGNXMM( double zx[ 2 ] );
+    ALIGNXMM( double zy[ 2 ] );
+
+    double result[ 2 ];
+
+    for ( int i = 0; i < count; i += 2 ) {
+        int x1 = columns[ i ];
+        int x2 = ( i + 1 < count ) ? columns[ i + 1 ] : x1;
+        zx[ 0 ] = input.m_x + input.m_ca * x1 + input.m_sa * y;
+        zx[ 1 ] = input.m_x + input.m_ca * x2 + input.m_sa * y;
+        zy[ 0 ] = input.m_y - input.m_sa * x1 + input.m_ca * y;
+        zy[ 1 ] = input.m_y - input.m_sa * x2 + input.m_ca * y;
+        ( *functor )( result, zx, zy, maxIterations );
+        row[ x1 ] = result[ 0 ];
+        if ( i + 1 < count )
+            row[ x2 ] = result[ 1 ];
+    }
+}
+
+void generatePointsSSE2( const double* zx, const double* zy, double* result, int count, FunctorSSE2* functor, int maxIterations )
+{
+    ALIGNXMM( double x[ 2 ] );
+    ALIGNXMM( double y[ 2 ] );
+
+    double values[ 2 ];
+
+    for ( int i = 0; i < count; i += 2 ) {
+        int j = ( i + 1 < count ) ? i + 1 : i;
+        x[ 0 ] = zx[ i ];
+        x[ 1 ] = zx[ j ];
+        y[ 0 ] = zy[ i ];
+        y[ 1 ] = zy[ j ];
+        ( *functor )( values, x, y, maxIterations );
+        result[ i ] = values[ 0 ];
+        if ( i + 1 < count )
+            result[ i + 1 ] = values[ 1 ];
+    }
+}
+
 #endif // defined( HAVE_SSE2 )
 
 } // namespace GeneratorCore
@@ -19,8 +19,11 @@
 #ifndef GENERATORCORE_H
 #define GENERATORCORE_H
 
+#include <QVector>
+
 #if defined( Q_OS_WIN64 ) && defined( _M_X64 )
 #undef HAVE_SSE2
+#undef HAVE_AVX2
 #endif
 
 namespace GeneratorCore
@@ -36,12 +39,30 @@ enum Variant
     AbsoluteImVariant
 };
 
+struct Sample
+{
+    double m_zx;
+    double m_zy;
+    int m_iterations; // 0 if not calculated, -1 if escaped
+    int m_offset; // position of the point in the output buffer
+};
+
 class Functor
 {
 public:
     virtual ~Functor() {}
 
     virtual double operator()( double zx, double zy, int maxIterations ) = 0;
+
+    // continue iterating the sample until it escapes or reaches maxIterations
+    virtual double resume( double zx, double zy, Sample* sample, int maxIterations ) = 0;
+
+    // also estimate the distance to the set in units of the plane; it's 0.0 if unknown
+    virtual double estimate( double zx, double zy, int maxIterations, double* distance )
+    {
+        *distance = 0.0;
+        return ( *this )( zx, zy, maxIterations );
+    }
 };
 
 Functor* createMandelbrotFunctor( double exponent, Variant variant );
@@ -68,28 +89,62 @@ struct Output
     int m_height; // N * CellSize + 1
 };
 
-void generatePreview( const Input& input, const Output& output, Functor* functor, int maxIterations );
-void generateDetails( const Input& input, const Output& output, Functor* functor, int maxIterations, double threshold );
+// distance estimates in pixels are stored at the grid points if the buffer is not NULL
+// and used to interpolate cells which are far from the boundary of the set;
+// flags have the same layout as the output buffer and mark the calculated detail
+// points, which are skipped by the following passes
+void generatePreview( const Input& input, const Output& output, Functor* functor, int maxIterations, double* distances = 0 );
+void generateDetails( const Input& input, const Output& output, Functor* functor, int maxIterations, double threshold,
+    double* distances = 0, unsigned char* flags = 0 );
+
+void interpolate( const Output& output, const unsigned char* flags = 0 );
+
+void generatePoints( const Input& input, double* row, int y, const int* columns, int count, Functor* functor, int maxIterations );
 
-void interpolate( const Output& output );
+// calculate points at arbitrary coordinates of the plane
+void generatePoints( const double* zx, const double* zy, double* result, int count, Functor* functor, int maxIterations );
+
+// continue iterating the calculated points which haven't escaped yet; only the orbits
+// of the points which still haven't escaped are kept in the samples, ordered by offset,
+// and points without a stored orbit are iterated again from the start
+void resumeSamples( const Input& input, const Output& output, const unsigned char* flags, QVector<Sample>* samples,
+    Functor* functor, int maxIterations );
+
+static const int HistogramSize = 24;
+
+// find the smallest limit for which the share of points escaping
+// after it is below the tolerance; the histogram contains the number
+// of escaped points in buckets of powers of two
+int probeIterations( const Input& input, int width, int height, Functor* functor, int minIterations, int maxIterations,
+    double tolerance, int histogram[] );
 
 #if defined( HAVE_SSE2 )
 
 bool isSSE2Available();
 
+#if defined( HAVE_AVX2 )
+bool isAVX2Available();
+#endif
+
 class FunctorSSE2
 {
 public:
     virtual ~FunctorSSE2() {}
 
     virtual void operator()( double result[], double zx[], double zy[], int maxIterations ) = 0;
+
+    virtual void estimate( double result[], double distance[], double zx[], double zy[], int maxIterations ) = 0;
 };
 
 FunctorSSE2* createMandelbrotFunctorSSE2( int exponent, Variant variant );
 FunctorSSE2* createJuliaFunctorSSE2( double cx, double cy, int exponent, Variant variant ); 
 
-void generatePreviewSSE2( const Input& input, const Output& output, FunctorSSE2* functor, int maxIterations );
-void generateDetailsSSE2( const Input& input, const Output& output, FunctorSSE2* functor, int maxIterations, double threshold );
+void generatePreviewSSE2( const Input& input, const Output& output, FunctorSSE2* functor, int maxIterations, double* distances = 0 );
+void generateDetailsSSE2( const Input& input, const Output& output, FunctorSSE2* functor, int maxIterations, double threshold,
+    double* distances = 0, unsigned char* flags = 0 );
+
+void generatePointsSSE2( const Input& input, double* row, int y, const int* columns, int count, FunctorSSE2* functor, int maxIterations );
+void generatePointsSSE2( const double* zx, const double* zy, double* result, int count, FunctorSSE2* functor, int maxIterations );
 
 #endif // defined( HAVE_SSE2 )
 
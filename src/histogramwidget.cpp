@@ -0,0 +1,94 @@
+/**************************************************************************
+* This file is part of the Fraqtive program
+* Copyright (C) 2004-2012 Michał Męciński
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**************************************************************************/
+
+#include "histogramwidget.h"
+
+#include <QPainter>
+#include <QPaintEvent>
+
+#include <math.h>
+
+HistogramWidget::HistogramWidget( QWidget* parent ) : QWidget( parent ),
+    m_limit( 0 )
+{
+}
+
+HistogramWidget::~HistogramWidget()
+{
+}
+
+void HistogramWidget::setHistogram( const QVector<int>& histogram, int limit )
+{
+    m_histogram = histogram;
+    m_limit = limit;
+
+    if ( m_limit > 0 )
+        setToolTip( tr( "Maximum iterations: %1" ).arg( m_limit ) );
+    else
+        setToolTip( QString() );
+
+    update();
+}
+
+QSize HistogramWidget::minimumSizeHint() const
+{
+    return QSize( 30, 40 );
+}
+
+void HistogramWidget::paintEvent( QPaintEvent* /*e*/ )
+{
+    QPainter painter( this );
+
+    QRectF frame = rect();
+    frame.adjust( 0.5, 0.5, -0.5, -0.5 );
+
+    painter.setPen( QColor( 80, 80, 80 ) );
+    painter.setBrush( QColor( 160, 160, 160 ) );
+    painter.drawRect( frame );
+
+    int count = m_histogram.count();
+    if ( count == 0 )
+        return;
+
+    int maximum = 0;
+    for ( int i = 0; i < count; i++ )
+        maximum = qMax( maximum, m_histogram.at( i ) );
+
+    QRectF area = frame.adjusted( 3.0, 3.0, -3.0, -3.0 );
+    double width = area.width() / count;
+
+    // bars use a square root scale so that rare escape times remain visible
+    painter.setPen( Qt::NoPen );
+    painter.setBrush( QColor( 255, 255, 255, 192 ) );
+
+    if ( maximum > 0 ) {
+        for ( int i = 0; i < count; i++ ) {
+            double height = area.height() * sqrt( (double)m_histogram.at( i ) / (double)maximum );
+            painter.drawRect( QRectF( area.left() + i * width, area.bottom() - height, width - 1.0, height ) );
+        }
+    }
+
+    // each bucket covers a half of a binary order of magnitude
+    if ( m_limit > 0 ) {
+        double position = qMin( 2.0 * log( (double)m_limit ) / log( 2.0 ), (double)count );
+        double x = area.left() + position * width;
+
+        painter.setPen( QColor( 192, 0, 0 ) );
+        painter.drawLine( QPointF( x, frame.top() ), QPointF( x, frame.bottom() ) );
+    }
+}
@@ -19,6 +19,7 @@
 #include "imagegenerator.h"
 
 #include <math.h>
+#include <string.h>
 
 #ifndef M_PI
 # define M_PI 3.14159265358979323846
@@ -27,15 +28,33 @@
 #include <QPalette>
 #include <QPainter>
 #include <QIcon>
+#include <QDataStream>
 
 #include "fraqtiveapplication.h"
 #include "fractaldata.h"
 #include "jobscheduler.h"
 #include "datafunctions.h"
+#include "tiffwriter.h"
+#include "checkpoint.h"
 
 ImageGenerator::ImageGenerator( QObject* parent ) : QObject( parent ),
-    m_gradientCache( NULL ),
+    m_multiSampling( 0 ),
+    m_adaptive( false ),
+    m_sampling( 0 ),
+    m_iterations( 0 ),
+    m_probing( false ),
     m_maximumProgress( 0 ),
+    m_mirrorRow( -1 ),
+    m_mirrorColumns( false ),
+    m_writer( NULL ),
+    m_checkpoint( NULL ),
+    m_stripCount( 0 ),
+    m_tilesPerStrip( 0 ),
+    m_maximumPendingStrips( 0 ),
+    m_queuedStrips( 0 ),
+    m_nextStrip( 0 ),
+    m_unqueuedJobs( 0 ),
+    m_writing( false ),
     m_activeJobs( 0 ),
     m_imageCount( 1 ),
     m_currentImage( 0 )
@@ -43,19 +62,36 @@ ImageGenerator::ImageGenerator( QObject* parent ) : QObject( parent ),
 }
 
 ImageGenerator::~ImageGenerator()
+{
+    abort();
+}
+
+void ImageGenerator::abort()
 {
     QMutexLocker locker( &m_mutex );
 
+    int stripCount = m_stripCount;
+
+    // strips which were not queued yet are never calculated
+    m_stripCount = m_queuedStrips;
+    m_unqueuedJobs = 0;
+
     cancelJobs();
 
     while ( m_activeJobs > 0 )
         m_allJobsDone.wait( &m_mutex );
 
-    delete[] m_gradientCache;
+    // an interrupted image can be continued from the last written strip
+    if ( m_checkpoint && m_writer && m_nextStrip > 0 && m_nextStrip < stripCount ) {
+        QByteArray state = m_writer->saveState();
+        if ( !state.isEmpty() )
+            m_checkpoint->save( m_nextStrip, state );
+    }
 }
 
-static const int CellsPerRegion = 20;
-static const int RegionSize = CellsPerRegion * GeneratorCore::CellSize + 1;
+static const int StripRows = 64;
+static const int TileWidth = 4096;
+static const int MaximumPendingTiles = 32;
 
 static int roundToCellSize( int size )
 {
@@ -63,19 +99,71 @@ static int roundToCellSize( int size )
     return ( ( size - 1 + GeneratorCore::CellSize - 1 ) / GeneratorCore::CellSize ) * GeneratorCore::CellSize + 1;
 }
 
+static QRect scaledRect( const QRect& rect, int shift )
+{
+    return QRect( rect.left() >> shift, rect.top() >> shift, rect.width() >> shift, rect.height() >> shift );
+}
+
 void ImageGenerator::setResolution( const QSize& resolution )
 {
     m_resolution = resolution;
 
-    int height = resolution.height() + 2;
+    calculateLayout();
+}
 
-    int fullRegions = height / ( RegionSize - 2 );
-    int remainder = height - fullRegions * ( RegionSize - 2 );
+void ImageGenerator::setMultiSampling( int multiSampling )
+{
+    m_multiSampling = multiSampling;
 
-    m_maximumProgress = fullRegions;
+    calculateLayout();
+}
 
-    if ( remainder > 0 )
-        m_maximumProgress++;
+void ImageGenerator::setAdaptiveSampling( bool adaptive )
+{
+    m_adaptive = adaptive;
+
+    calculateLayout();
+}
+
+void ImageGenerator::setRegion( const QRect& region )
+{
+    m_region = region;
+
+    calculateLayout();
+}
+
+void ImageGenerator::setCheckpoint( Checkpoint* checkpoint )
+{
+    m_checkpoint = checkpoint;
+}
+
+bool ImageGenerator::canResume()
+{
+    if ( !m_checkpoint )
+        return false;
+
+    m_checkpoint->setParameters( checkpointParameters() );
+
+    return m_checkpoint->load();
+}
+
+void ImageGenerator::calculateLayout()
+{
+    // adaptive sampling calculates tiles at the final resolution and refines them later
+    m_sampling = m_adaptive ? 0 : m_multiSampling;
+
+    // only the selected region of the image is generated, with the geometry of the whole image
+    m_imageSize = m_region.isValid() ? m_region.size() : m_resolution;
+
+    m_sampledResolution = m_resolution * ( 1 << m_sampling );
+    m_sampledSize = m_imageSize * ( 1 << m_sampling );
+    m_sampledOffset = m_region.isValid() ? m_region.topLeft() * ( 1 << m_sampling ) : QPoint();
+
+    // strips and tiles are multiples of the sampling factor so they can be downsampled separately
+    m_stripCount = ( m_sampledSize.height() + StripRows - 1 ) / StripRows;
+    m_tilesPerStrip = ( m_sampledSize.width() + TileWidth - 1 ) / TileWidth;
+
+    m_maximumProgress = m_stripCount * m_tilesPerStrip;
 }
 
 void ImageGenerator::setParameters( const FractalType& type, const Position& position )
@@ -84,14 +172,10 @@ void ImageGenerator::setParameters( const FractalType& type, const Position& pos
     m_position = position;
 }
 
-static const int GradientSize = 16384;
-
 void ImageGenerator::setColorSettings( const Gradient& gradient, const QColor& backgroundColor, const ColorMapping& mapping )
 {
-    if ( !m_gradientCache )
-        m_gradientCache = new QRgb[ GradientSize ];
-
-    DataFunctions::fillGradientCache( gradient, m_gradientCache, GradientSize );
+    m_gradient = gradient;
+    m_gradientCache = DataFunctions::sharedGradientCache( gradient, DataFunctions::GradientSize );
 
     m_backgroundColor = backgroundColor;
     m_colorMapping = mapping;
@@ -126,32 +210,222 @@ QImage ImageGenerator::takeImage()
 
 bool ImageGenerator::start()
 {
-    m_image = QImage( m_resolution, QImage::Format_RGB32 );
+    m_image = QImage( m_imageSize, QImage::Format_RGB32 );
 
     if ( m_image.isNull() )
         return false;
 
+    prepare();
+
+    // the whole image is kept in memory so all strips are queued at once
+    m_maximumPendingStrips = m_stripCount;
+
+    m_drawnRows = QVector<bool>( m_imageSize.height(), false );
+
+    calculateSymmetry();
+
+    if ( m_probing )
+        addJobs( 1 );
+    else
+        queueStrips();
+
+    return true;
+}
+
+bool ImageGenerator::startStreaming( TiffWriter* writer, bool resume /*= false*/ )
+{
+    int firstStrip = 0;
+
+    // strips which were already written to the file are not calculated again
+    if ( resume && canResume() && writer->resume( m_imageSize, StripRows >> m_sampling, m_checkpoint->state() ) )
+        firstStrip = m_checkpoint->progress();
+    else if ( !writer->open( m_imageSize, StripRows >> m_sampling ) )
+        return false;
+
+    if ( m_checkpoint )
+        m_checkpoint->setParameters( checkpointParameters() );
+
+    m_image = QImage();
+
+    prepare();
+
+    m_writer = writer;
+
+    m_queuedStrips = firstStrip;
+    m_nextStrip = firstStrip;
+    m_unqueuedJobs -= firstStrip * m_tilesPerStrip;
+
+    // only a few strips are kept in memory before they are written
+    m_maximumPendingStrips = qMax( MaximumPendingTiles / m_tilesPerStrip, 2 );
+
+    if ( m_probing )
+        addJobs( 1 );
+    else
+        queueStrips();
+
+    return true;
+}
+
+void ImageGenerator::prepare()
+{
+    calculateLayout();
+
     m_regions.clear();
 
-    int width = roundToCellSize( m_image.width() + 2 );
-    int height = m_image.height() + 2;
+    m_mirrorRegions.clear();
+    m_deferredRegions.clear();
+    m_drawnRows.clear();
+    m_mirrorRow = -1;
+    m_mirrorColumns = false;
+
+    m_writer = NULL;
+
+    m_queuedStrips = 0;
+    m_nextStrip = 0;
+    m_unqueuedJobs = m_maximumProgress;
+    m_writing = false;
+
+    m_strips = QVector<QImage>( m_stripCount );
+    m_remainingTiles = QVector<int>( m_stripCount, m_tilesPerStrip );
+
+    // each frame of a series gets its own estimate; it's calculated by the first job
+    // and the strips are queued when it's finished
+    m_iterations = (int)( pow( 10.0, m_generatorSettings.calculationDepth() ) * qMax( 1.0, 1.45 + m_position.zoomFactor() ) );
+
+    m_probing = m_generatorSettings.automaticDepth();
+}
+
+void ImageGenerator::probeIterations()
+{
+    FractalType type = m_type;
+    Position position = m_position;
+    QSize resolution = m_sampledResolution;
+    int iterations = m_iterations;
+
+    m_mutex.unlock();
+
+    iterations = DataFunctions::estimateIterations( type, position, resolution, iterations, NULL );
+
+    m_mutex.lock();
 
-    int fullRegions = height / ( RegionSize - 2 );
-    int remainder = height - fullRegions * ( RegionSize - 2 );
+    m_iterations = iterations;
+    m_probing = false;
 
-    for ( int i = 0; i < fullRegions; i++ ) {
-        QRect region( 0, i * ( RegionSize - 2 ), width, RegionSize );
-        m_regions.append( region );
+    // nothing is queued if the image was aborted in the meantime
+    queueStrips();
+}
+
+void ImageGenerator::queueStrips()
+{
+    int count = 0;
+
+    while ( m_queuedStrips < m_stripCount && m_queuedStrips - m_nextStrip < m_maximumPendingStrips ) {
+        int top = m_queuedStrips * StripRows;
+        int rows = qMin( StripRows, m_sampledSize.height() - top );
+
+        if ( m_writer )
+            m_strips[ m_queuedStrips ] = QImage( m_imageSize.width(), rows >> m_sampling, QImage::Format_RGB32 );
+
+        // strips in which all rows are symmetric to other rows are copied from the image
+        int firstRow = top >> m_sampling;
+        int lastRow = ( ( top + rows ) >> m_sampling ) - 1;
+        bool mirrored = m_mirrorRow >= 0 && 2 * firstRow > m_mirrorRow && lastRow <= m_mirrorRow;
+
+        for ( int left = 0; left < m_sampledSize.width(); left += TileWidth ) {
+            int columns = qMin( TileWidth, m_sampledSize.width() - left );
+            QRect region( left, top, roundToCellSize( columns + 2 ), roundToCellSize( rows + 2 ) );
+
+            m_regions.append( region );
+            if ( mirrored )
+                m_mirrorRegions.append( region );
+        }
+
+        m_queuedStrips++;
+        count += m_tilesPerStrip;
     }
 
-    if ( remainder > 0 ) {
-        QRect region( 0, fullRegions * ( RegionSize - 2 ), width, roundToCellSize( remainder ) );
-        m_regions.append( region );
+    m_unqueuedJobs -= count;
+    addJobs( count );
+}
+
+void ImageGenerator::storeTile( const QRect& rect, const QImage& tile )
+{
+    int index = rect.top() / StripRows;
+
+    // streamed tiles are copied to their strip, other tiles directly to the image
+    QImage& target = m_writer ? m_strips[ index ] : m_image;
+
+    QRect scaled = scaledRect( rect, m_sampling );
+    int top = m_writer ? 0 : scaled.top();
+
+    for ( int y = 0; y < tile.height(); y++ )
+        memcpy( target.scanLine( top + y ) + scaled.left() * sizeof( QRgb ), tile.scanLine( y ), tile.width() * sizeof( QRgb ) );
+
+    if ( --m_remainingTiles[ index ] == 0 )
+        finishStrip( index );
+}
+
+void ImageGenerator::finishStrip( int index )
+{
+    if ( m_writer ) {
+        writeStrips();
+        return;
     }
 
-    addJobs();
+    int top = ( index * StripRows ) >> m_sampling;
+    int bottom = qMin( ( ( index + 1 ) * StripRows ) >> m_sampling, m_imageSize.height() );
 
-    return true;
+    for ( int y = top; y < bottom; y++ )
+        m_drawnRows[ y ] = true;
+
+    // copy the mirrored tiles which were waiting for these rows
+    QList<QRect> deferred = m_deferredRegions;
+    m_deferredRegions.clear();
+
+    for ( int i = 0; i < deferred.count(); i++ )
+        mirrorRegion( deferred.at( i ) );
+}
+
+void ImageGenerator::writeStrips()
+{
+    // the job which is already writing also writes the following strips
+    if ( m_writing )
+        return;
+
+    m_writing = true;
+
+    while ( m_nextStrip < m_queuedStrips && m_remainingTiles.at( m_nextStrip ) == 0 ) {
+        QImage strip = m_strips.at( m_nextStrip );
+        m_strips[ m_nextStrip ] = QImage();
+
+        int writtenStrips = m_nextStrip + 1;
+
+        m_mutex.unlock();
+
+        bool written = m_writer->writeStrip( strip );
+
+        // the written strips are recorded from time to time so that the image can be resumed;
+        // the last strip is never recorded so that a resumed image always has strips to calculate
+        if ( written && m_checkpoint && writtenStrips < m_stripCount && m_checkpoint->isDue() ) {
+            QByteArray state = m_writer->saveState();
+            if ( !state.isEmpty() )
+                m_checkpoint->save( writtenStrips, state );
+        }
+
+        m_mutex.lock();
+
+        m_nextStrip++;
+
+        // stop calculating when the file cannot be written
+        if ( !written ) {
+            m_stripCount = m_queuedStrips;
+            m_unqueuedJobs = 0;
+        }
+
+        queueStrips();
+    }
+
+    m_writing = false;
 }
 
 int ImageGenerator::priority() const
@@ -163,12 +437,111 @@ void ImageGenerator::executeJob()
 {
     QMutexLocker locker( &m_mutex );
 
-    if ( m_regions.count() > 0 )
-        calculateRegion( m_regions.takeFirst() );
+    if ( m_probing ) {
+        probeIterations();
+    } else if ( m_regions.count() > 0 ) {
+        QRect region = m_regions.takeFirst();
+        if ( m_mirrorRegions.contains( region ) )
+            mirrorRegion( region );
+        else
+            calculateRegion( region );
+    }
 
     finishJob();
 }
 
+static const int EdgeThreshold = 24;
+
+static inline bool isEdge( QRgb color1, QRgb color2 )
+{
+    return qAbs( qRed( color1 ) - qRed( color2 ) ) + qAbs( qGreen( color1 ) - qGreen( color2 ) ) + qAbs( qBlue( color1 ) - qBlue( color2 ) ) > EdgeThreshold;
+}
+
+static inline void calculatePoints( const GeneratorCore::Input& input, double* row, int y, const int* columns, int count,
+    GeneratorCore::Functor* functor, int maxIterations )
+{
+    GeneratorCore::generatePoints( input, row, y, columns, count, functor, maxIterations );
+}
+
+#if defined( HAVE_SSE2 )
+
+static inline void calculatePoints( const GeneratorCore::Input& input, double* row, int y, const int* columns, int count,
+    GeneratorCore::FunctorSSE2* functor, int maxIterations )
+{
+    GeneratorCore::generatePointsSSE2( input, row, y, columns, count, functor, maxIterations );
+}
+
+#endif
+
+template<class FUNCTOR>
+static void refineEdges( QImage& tile, const GeneratorCore::Input& input, const FractalData* data, const DataFunctions::ColorMapper& mapper,
+    FUNCTOR* functor, int maxIterations, int multiSampling )
+{
+    int width = tile.width();
+    int height = tile.height();
+
+    // the data includes a margin of one point around the tile
+    int stride = width + 2;
+    QVector<QRgb> colors( stride * ( height + 2 ) );
+
+    for ( int y = 0; y < height + 2; y++ )
+        mapper.mapRow( colors.data() + y * stride, data->buffer() + y * data->stride(), stride );
+
+    int factor = 1 << multiSampling;
+    int area = factor * factor;
+
+    QVector<int> columns( width );
+    QVector<double> row( stride );
+
+    for ( int y = 0; y < height; y++ ) {
+        const QRgb* above = colors.constData() + y * stride;
+        const QRgb* middle = above + stride;
+        const QRgb* below = middle + stride;
+
+        int count = 0;
+
+        for ( int x = 0; x < width; x++ ) {
+            QRgb color = middle[ x + 1 ];
+            if ( isEdge( color, above[ x ] ) || isEdge( color, above[ x + 1 ] ) || isEdge( color, above[ x + 2 ] )
+                || isEdge( color, middle[ x ] ) || isEdge( color, middle[ x + 2 ] )
+                || isEdge( color, below[ x ] ) || isEdge( color, below[ x + 1 ] ) || isEdge( color, below[ x + 2 ] ) )
+                columns[ count++ ] = x + 1;
+        }
+
+        if ( count == 0 )
+            continue;
+
+        // the samples of each pixel form a block of the strip which is downsampled
+        // using the same filter as uniform multi-sampling
+        QImage strip( count * factor, factor, QImage::Format_RGB32 );
+
+        for ( int i = 0; i < area; i++ ) {
+            // samples are placed in the centers of the sub-pixels, like the samples of uniform multi-sampling
+            double offsetX = ( (double)( i % factor ) + 0.5 ) / (double)factor - 0.5;
+            double offsetY = ( (double)( i / factor ) + 0.5 ) / (double)factor - 0.5;
+
+            GeneratorCore::Input shifted = input;
+            shifted.m_x += input.m_ca * offsetX + input.m_sa * offsetY;
+            shifted.m_y += -input.m_sa * offsetX + input.m_ca * offsetY;
+
+            calculatePoints( shifted, row.data(), y + 1, columns.constData(), count, functor, maxIterations );
+
+            QRgb* samples = reinterpret_cast<QRgb*>( strip.scanLine( i / factor ) ) + i % factor;
+
+            for ( int j = 0; j < count; j++ )
+                samples[ j * factor ] = mapper.map( row.at( columns.at( j ) ) );
+        }
+
+        QImage pixels = DataFunctions::downsampleImage( strip, multiSampling );
+
+        const QRgb* source = reinterpret_cast<const QRgb*>( pixels.scanLine( 0 ) );
+        QRgb* dest = reinterpret_cast<QRgb*>( tile.scanLine( y ) );
+
+        for ( int j = 0; j < count; j++ )
+            dest[ columns.at( j ) - 1 ] = source[ j ];
+    }
+}
+
 void ImageGenerator::calculateRegion( const QRect& region )
 {
     GeneratorCore::Input input;
@@ -180,48 +553,157 @@ void ImageGenerator::calculateRegion( const QRect& region )
     int maxIterations = maximumIterations();
     double threshold = m_generatorSettings.detailThreshold();
 
+    int refinement = m_adaptive ? m_multiSampling : 0;
+
     m_mutex.unlock();
 
+    // distances of the grid points are only needed until the details are calculated
+    double* distances = new double[ output.m_stride * output.m_height ];
+
+    GeneratorCore::Functor* functor = NULL;
+
 #if defined( HAVE_SSE2 )
     GeneratorCore::FunctorSSE2* functorSSE2 = DataFunctions::createFunctorSSE2( m_type );
     if ( functorSSE2 ) {
-        GeneratorCore::generatePreviewSSE2( input, output, functorSSE2, maxIterations );
+        GeneratorCore::generatePreviewSSE2( input, output, functorSSE2, maxIterations, distances );
         GeneratorCore::interpolate( output );
-        GeneratorCore::generateDetailsSSE2( input, output, functorSSE2, maxIterations, threshold );
-        delete functorSSE2;
+        GeneratorCore::generateDetailsSSE2( input, output, functorSSE2, maxIterations, threshold, distances );
     } else {
 #endif
-        GeneratorCore::Functor* functor = DataFunctions::createFunctor( m_type );
+        functor = DataFunctions::createFunctor( m_type );
         if ( functor ) {
-            GeneratorCore::generatePreview( input, output, functor, maxIterations );
+            GeneratorCore::generatePreview( input, output, functor, maxIterations, distances );
             GeneratorCore::interpolate( output );
-            GeneratorCore::generateDetails( input, output, functor, maxIterations, threshold );
-            delete functor;
+            GeneratorCore::generateDetails( input, output, functor, maxIterations, threshold, distances );
         }
 #if defined( HAVE_SSE2 )
     }
 #endif
 
-    m_mutex.lock();
+    delete[] distances;
 
     FractalData data;
     data.transferBuffer( output.m_buffer, output.m_stride, region.size() );
 
-    DataFunctions::ColorMapper mapper( m_gradientCache, GradientSize, m_backgroundColor.rgb(), m_colorMapping );
+    DataFunctions::ColorMapper mapper( m_gradientCache.constData(), m_gradientCache.count(), m_backgroundColor.rgb(), m_colorMapping );
+
+    // tiles are colored and downsampled separately and only copied to the image
+    QRect rect = imageRegion( region );
+
+    QImage tile( rect.size(), QImage::Format_RGB32 );
+    DataFunctions::drawImage( tile, QPoint( 0, 0 ), &data, QRect( QPoint( 0, 0 ), rect.size() ), mapper, m_viewSettings.antiAliasing() );
+
+    // only the pixels which differ from their neighbors are calculated again using multiple samples
+    if ( refinement > 0 ) {
+#if defined( HAVE_SSE2 )
+        if ( functorSSE2 )
+            refineEdges( tile, input, &data, mapper, functorSSE2, maxIterations, refinement );
+#endif
+        if ( functor )
+            refineEdges( tile, input, &data, mapper, functor, maxIterations, refinement );
+    }
+
+#if defined( HAVE_SSE2 )
+    delete functorSSE2;
+#endif
+    delete functor;
+
+    tile = DataFunctions::downsampleImage( tile, m_sampling );
+
+    m_mutex.lock();
+
+    storeTile( rect, tile );
+}
+
+void ImageGenerator::mirrorRegion( const QRect& region )
+{
+    QRect rect = scaledRect( imageRegion( region ), m_sampling );
+
+    for ( int y = rect.top(); y <= rect.bottom(); y++ ) {
+        if ( !m_drawnRows.at( m_mirrorRow - y ) ) {
+            m_deferredRegions.append( region );
+            return;
+        }
+    }
+
+    int width = m_image.width();
+
+    for ( int y = rect.top(); y <= rect.bottom(); y++ ) {
+        QRgb* dest = reinterpret_cast<QRgb*>( m_image.scanLine( y ) );
+        const QRgb* source = reinterpret_cast<const QRgb*>( m_image.scanLine( m_mirrorRow - y ) );
+
+        if ( m_mirrorColumns ) {
+            for ( int x = rect.left(); x <= rect.right(); x++ )
+                dest[ x ] = source[ width - 1 - x ];
+        } else {
+            memcpy( dest + rect.left(), source + rect.left(), rect.width() * sizeof( QRgb ) );
+        }
+    }
+
+    int index = region.top() / StripRows;
+
+    if ( --m_remainingTiles[ index ] == 0 )
+        finishStrip( index );
+}
 
-    DataFunctions::drawImage( m_image, region.topLeft(), &data, QRect( 0, 0, m_image.width(), qMin( region.height() - 2, m_image.height() - region.top() ) ),
-        mapper, m_viewSettings.antiAliasing() );
+static const double SymmetryTolerance = 1e-6;
+
+void ImageGenerator::calculateSymmetry()
+{
+    m_mirrorRow = -1;
+    m_mirrorColumns = false;
+
+    // symmetric rows may lie outside of a partial image
+    if ( m_region.isValid() )
+        return;
+
+    int height = m_sampledResolution.height();
+
+    QPointF center;
+    DataFunctions::Symmetry symmetry = DataFunctions::findSymmetry( m_type, m_position, height, &center );
+    if ( symmetry == DataFunctions::NoSymmetry )
+        return;
+
+    // sample y is symmetric to mirrorRow - y; anti-aliasing and downsampling
+    // use symmetric filters so the colors can be copied directly
+    double row = (double)( height - 1 ) + 2.0 * center.y();
+    if ( row < 0.0 || row > 2.0 * (double)( height - 1 ) )
+        return;
+
+    int mirrorRow = (int)floor( row + 0.5 );
+    if ( fabs( row - (double)mirrorRow ) > SymmetryTolerance )
+        return;
+
+    // the blocks of samples which form a pixel must be mirrored as a whole
+    int factor = 1 << m_sampling;
+    if ( ( mirrorRow + 1 ) % factor != 0 )
+        return;
+
+    // rotated pixels must all lie within the image, so the center of the view must be the center of symmetry
+    if ( symmetry == DataFunctions::PointSymmetry ) {
+        if ( fabs( center.x() ) > SymmetryTolerance )
+            return;
+        m_mirrorColumns = true;
+    }
+
+    m_mirrorRow = ( mirrorRow + 1 ) / factor - 1;
+}
+
+QRect ImageGenerator::imageRegion( const QRect& region ) const
+{
+    return QRect( region.left(), region.top(), qMin( region.width() - 2, m_sampledSize.width() - region.left() ),
+        qMin( region.height() - 2, m_sampledSize.height() - region.top() ) );
 }
 
 void ImageGenerator::calculateInput( GeneratorCore::Input* input, const QRect& region )
 {
-    double scale = pow( 10.0, -m_position.zoomFactor() ) / (double)m_image.height();
+    double scale = pow( 10.0, -m_position.zoomFactor() ) / (double)m_sampledResolution.height();
 
     double sa = scale * sin( m_position.angle() * M_PI / 180.0 );
     double ca = scale * cos( m_position.angle() * M_PI / 180.0 );
 
-    double offsetX = (double)region.left() - (double)m_image.width() / 2.0 - 0.5;
-    double offsetY = (double)region.top() - (double)m_image.height() / 2.0 - 0.5;
+    double offsetX = (double)( region.left() + m_sampledOffset.x() ) - (double)m_sampledResolution.width() / 2.0 - 0.5;
+    double offsetY = (double)( region.top() + m_sampledOffset.y() ) - (double)m_sampledResolution.height() / 2.0 - 0.5;
 
     input->m_sa = sa;
     input->m_ca = ca;
@@ -239,12 +721,22 @@ void ImageGenerator::calculateOutput( GeneratorCore::Output* output, const QRect
 
 int ImageGenerator::maximumIterations() const
 {
-    return (int)( pow( 10.0, m_generatorSettings.calculationDepth() ) * qMax( 1.0, 1.45 + m_position.zoomFactor() ) );
+    return m_iterations;
+}
+
+QByteArray ImageGenerator::checkpointParameters() const
+{
+    QByteArray parameters;
+    QDataStream stream( &parameters, QIODevice::WriteOnly );
+
+    stream << m_type << m_position << m_resolution << m_region << (qint32)m_multiSampling << m_adaptive
+        << m_gradient << m_backgroundColor << m_colorMapping << m_generatorSettings << m_viewSettings;
+
+    return parameters;
 }
 
-void ImageGenerator::addJobs()
+void ImageGenerator::addJobs( int count )
 {
-    int count = m_regions.count();
     if ( count > 0 ) {
         fraqtive()->jobScheduler()->addJobs( this, count );
         m_activeJobs += count;
@@ -256,7 +748,7 @@ void ImageGenerator::cancelJobs()
     int count = fraqtive()->jobScheduler()->cancelAllJobs( this );
     m_activeJobs -= count;
 
-    emit progressChanged( m_maximumProgress * m_currentImage + m_maximumProgress - m_activeJobs );
+    emit progressChanged( m_maximumProgress * m_currentImage + m_maximumProgress - m_activeJobs - m_unqueuedJobs );
 
     if ( m_activeJobs == 0 )
         m_allJobsDone.wakeAll();
@@ -266,7 +758,7 @@ void ImageGenerator::finishJob()
 {
     m_activeJobs--;
 
-    emit progressChanged( m_maximumProgress * m_currentImage + m_maximumProgress - m_activeJobs );
+    emit progressChanged( m_maximumProgress * m_currentImage + m_maximumProgress - m_activeJobs - m_unqueuedJobs );
 
     if ( m_activeJobs == 0 ) {
         m_allJobsDone.wakeAll();
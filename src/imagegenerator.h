@@ -23,10 +23,14 @@
 #include <QMutex>
 #include <QWaitCondition>
 #include <QImage>
+#include <QVector>
 
 #include "abstractjobprovider.h"
 #include "datastructures.h"
 
+class TiffWriter;
+class Checkpoint;
+
 class ImageGenerator : public QObject, public AbstractJobProvider
 {
     Q_OBJECT
@@ -36,11 +40,18 @@ public:
 
 public:
     void setResolution( const QSize& resolution );
+    void setMultiSampling( int multiSampling );
+    void setAdaptiveSampling( bool adaptive );
     void setParameters( const FractalType& type, const Position& position );
     void setColorSettings( const Gradient& gradient, const QColor& backgroundColor, const ColorMapping& mapping );
     void setGeneratorSettings( const GeneratorSettings& settings );
     void setViewSettings( const ViewSettings& settings );
 
+    void setRegion( const QRect& region );
+
+    void setCheckpoint( Checkpoint* checkpoint );
+    bool canResume();
+
     void setImageCount( int count );
     void setCurrentImage( int image );
 
@@ -49,6 +60,9 @@ public:
     QImage takeImage();
 
     bool start();
+    bool startStreaming( TiffWriter* writer, bool resume = false );
+
+    void abort();
 
 public: // AbstractJobProvider implementation
     int priority() const;
@@ -61,23 +75,54 @@ signals:
 
 private:
     void calculateRegion( const QRect& region );
+    void mirrorRegion( const QRect& region );
+
+    void calculateSymmetry();
+
+    QRect imageRegion( const QRect& region ) const;
+
+    void calculateLayout();
+
+    void prepare();
+    void probeIterations();
+
+    void queueStrips();
+    void storeTile( const QRect& rect, const QImage& tile );
+    void finishStrip( int index );
+    void writeStrips();
 
     void calculateInput( GeneratorCore::Input* input, const QRect& region );
     void calculateOutput( GeneratorCore::Output* output, const QRect& region );
 
     int maximumIterations() const;
 
-    void addJobs();
+    QByteArray checkpointParameters() const;
+
+    void addJobs( int count );
     void cancelJobs();
     void finishJob();
 
 private:
     QSize m_resolution;
+    int m_multiSampling;
+    bool m_adaptive;
+
+    QRect m_region;
+    QSize m_imageSize;
+
+    int m_sampling;
+    QSize m_sampledResolution;
+    QSize m_sampledSize;
+    QPoint m_sampledOffset;
 
     FractalType m_type;
     Position m_position;
 
-    QRgb* m_gradientCache;
+    int m_iterations;
+    bool m_probing;
+
+    Gradient m_gradient;
+    QVector<QRgb> m_gradientCache;
     QColor m_backgroundColor;
     ColorMapping m_colorMapping;
 
@@ -92,6 +137,29 @@ private:
 
     QList<QRect> m_regions;
 
+    int m_mirrorRow;
+    bool m_mirrorColumns;
+
+    QList<QRect> m_mirrorRegions;
+    QList<QRect> m_deferredRegions;
+    QVector<bool> m_drawnRows;
+
+    TiffWriter* m_writer;
+
+    Checkpoint* m_checkpoint;
+
+    int m_stripCount;
+    int m_tilesPerStrip;
+    int m_maximumPendingStrips;
+
+    int m_queuedStrips;
+    int m_nextStrip;
+    int m_unqueuedJobs;
+    bool m_writing;
+
+    QVector<QImage> m_strips;
+    QVector<int> m_remainingTiles;
+
     int m_activeJobs;
     QWaitCondition m_allJobsDone;
 
@@ -19,6 +19,7 @@
 #include "imageview.h"
 
 #include <math.h>
+#include <string.h>
 
 #ifndef M_PI
 # define M_PI 3.14159265358979323846
@@ -29,6 +30,7 @@
 #include <QMouseEvent>
 #include <QWheelEvent>
 #include <QKeyEvent>
+#include <QTimer>
 
 #include "fractalpresenter.h"
 #include "datafunctions.h"
@@ -36,15 +38,20 @@
 ImageView::ImageView( QWidget* parent, FractalPresenter* presenter ) : QWidget( parent ),
     m_presenter( presenter ),
     m_interactive( false ),
-    m_gradientCache( NULL ),
+    m_tileColumns( 0 ),
+    m_colorSerial( -1 ),
     m_tracking( NoTracking )
 {
     setContextMenuPolicy( Qt::PreventContextMenu );
+
+    m_flyTimer = new QTimer( this );
+    m_flyTimer->setInterval( 20 );
+
+    connect( m_flyTimer, SIGNAL( timeout() ), this, SLOT( flyStep() ) );
 }
 
 ImageView::~ImageView()
 {
-    delete[] m_gradientCache;
 }
 
 void ImageView::setInteractive( bool interactive )
@@ -63,9 +70,17 @@ void ImageView::setInteractive( bool interactive )
 void ImageView::clearView()
 {
     m_image = QImage();
+    m_backImage = QImage();
+    m_indexImage = QImage();
     m_updatedRegion = QRect();
+
+    stopFlying();
     m_tracking = NoTracking;
 
+    m_pyramid.clear();
+
+    invalidateTiles( QRect() );
+
     if ( m_interactive ) {
         m_presenter->clearTracking();
         m_presenter->clearHovering();
@@ -79,17 +94,35 @@ void ImageView::transformView( const QTransform& transform )
     if ( m_image.isNull() )
         return;
 
-    QImage image( size(), QImage::Format_RGB32 );
+    QTransform step = transform * m_scale;
+
+    // keep the previous view if it's complete so that it can fill areas outside of the new view
+    transformPyramid( step );
+    if ( m_updatedRegion == m_image.rect() )
+        storeLevel( step );
+
+    // reuse the previous image instead of allocating a new one every time
+    QImage image = m_backImage;
+    m_backImage = QImage();
+
+    if ( image.size() != size() )
+        image = QImage( size(), QImage::Format_RGB32 );
     image.fill( m_backgroundColor.rgb() );
 
     QPainter painter( &image );
     painter.setRenderHint( QPainter::SmoothPixmapTransform );
-    painter.setWorldTransform( transform * m_scale );
-    painter.drawImage( 0, 0, m_image );
+    drawPyramid( &painter, QTransform(), CoarseLevels );
+    painter.setWorldTransform( step );
+    painter.drawImage( 0, 0, displayedImage( m_image.rect() ) );
+    drawPyramid( &painter, QTransform(), FineLevels );
+    painter.end();
 
+    m_backImage = m_image;
     m_image = image;
     m_updatedRegion = QRect();
 
+    invalidateTiles( m_image.rect() );
+
     calculateScale();
     update();
 }
@@ -104,11 +137,15 @@ void ImageView::initialUpdate( const FractalData* data )
             QPainter painter( &image );
             painter.setRenderHint( QPainter::SmoothPixmapTransform );
             painter.setWorldTransform( m_scale );
-            painter.drawImage( 0, 0, m_image );
+            painter.drawImage( 0, 0, displayedImage( m_image.rect() ) );
+
+            transformPyramid( m_scale );
         }
 
         m_image = image;
 
+        invalidateTiles( m_image.rect() );
+
         calculateScale();
         update();
     }
@@ -119,6 +156,32 @@ void ImageView::initialUpdate( const FractalData* data )
 
 void ImageView::partialUpdate( const FractalData* data )
 {
+    // the image is colored by the generator, only copy the new rows
+    if ( data->image() ) {
+        // rows which were already copied are copied again after the generator recolors them
+        if ( data->colorSerial() != m_colorSerial ) {
+            m_colorSerial = data->colorSerial();
+            m_updatedRegion = QRect();
+        }
+
+        const QList<QRect> coloredRegions = data->coloredRegions();
+
+        if ( coloredRegions.count() > 0 && coloredRegions.first().top() == 0 && coloredRegions.first().bottom() > m_updatedRegion.bottom()
+            && data->image()->size() == m_image.size() ) {
+            int top = m_updatedRegion.bottom() + 1;
+            QRect region( 0, top, m_image.width(), coloredRegions.first().bottom() - top + 1 );
+            copyImage( data, region );
+            m_updatedRegion = coloredRegions.first();
+
+            invalidateTiles( region );
+
+            update( worldTransform().mapRect( region ).adjusted( -1, -1, 1, 1 ) );
+        }
+        return;
+    }
+
+    m_colorSerial = -1;
+
     const QList<QRect> validRegions = data->validRegions();
 
     if ( validRegions.count() > 0 && validRegions.first().top() == 0 && validRegions.first().bottom() > m_updatedRegion.bottom() ) {
@@ -127,23 +190,28 @@ void ImageView::partialUpdate( const FractalData* data )
         drawImage( data, region );
         m_updatedRegion = validRegions.first();
 
+        invalidateTiles( region );
+
         update( worldTransform().mapRect( region ).adjusted( -1, -1, 1, 1 ) );
     }
 }
 
 void ImageView::fullUpdate( const FractalData* data )
 {
+    // the data isn't colored by the generator
+    m_colorSerial = -1;
+
     m_image = QImage( data->size() - QSize( 2, 2 ), QImage::Format_RGB32 );
     drawImage( data, m_image.rect() );
 
     m_updatedRegion = m_image.rect();
 
+    invalidateTiles( m_image.rect() );
+
     calculateScale();
     update();
 }
 
-static const int GradientSize = 16384;
-
 void ImageView::drawImage( const FractalData* data, const QRect& region )
 {
     ColorMapping mapping = m_colorMapping;
@@ -152,10 +220,47 @@ void ImageView::drawImage( const FractalData* data, const QRect& region )
         offset -= 1.0;
     mapping.setOffset( offset );
 
-    DataFunctions::ColorMapper mapper( m_gradientCache, GradientSize, m_backgroundColor.rgb(), mapping );
+    DataFunctions::ColorMapper mapper( m_gradientCache.constData(), m_gradientCache.count(), m_backgroundColor.rgb(), mapping );
     DataFunctions::drawImage( m_image, data, region, mapper, m_settings.antiAliasing() );
 }
 
+void ImageView::copyImage( const FractalData* data, const QRect& region )
+{
+    if ( m_indexImage.size() != m_image.size() ) {
+        m_indexImage = QImage( m_image.size(), QImage::Format_Indexed8 );
+        updateColorTable();
+    }
+
+    int bytes = region.width() * sizeof( QRgb );
+
+    for ( int y = region.top(); y <= region.bottom(); y++ ) {
+        memcpy( m_image.scanLine( y ), data->image()->scanLine( y ), bytes );
+        memcpy( m_indexImage.scanLine( y ), data->indexImage()->scanLine( y ), region.width() );
+    }
+}
+
+bool ImageView::isScrolled() const
+{
+    return m_colorSerial >= 0 && m_animationState.scrolling() != 0.0 && m_indexImage.size() == m_image.size();
+}
+
+QImage ImageView::displayedImage( const QRect& rect ) const
+{
+    if ( !isScrolled() )
+        return rect == m_image.rect() ? m_image : m_image.copy( rect );
+
+    // scrolled colors are only available for the rows which were already delivered
+    QImage image = m_image.copy( rect );
+
+    QRect indexed = rect.intersected( m_updatedRegion );
+    if ( !indexed.isEmpty() ) {
+        QPainter painter( &image );
+        painter.drawImage( indexed.topLeft() - rect.topLeft(), m_indexImage, indexed );
+    }
+
+    return image;
+}
+
 void ImageView::setColorSettings( const Gradient& gradient, const QColor& backgroundColor, const ColorMapping& mapping )
 {
     m_gradient = gradient;
@@ -201,16 +306,34 @@ void ImageView::setAnimationState( const AnimationState& state )
 {
     if ( m_animationState.scrolling() != state.scrolling() ) {
         m_animationState = state;
+
+        // colors of the image delivered by the generator are scrolled by rotating the color table
+        if ( m_colorSerial >= 0 ) {
+            updateColorTable();
+            invalidateTiles( m_image.rect() );
+            update();
+            return;
+        }
+
         updateImage();
     }
 }
 
 void ImageView::updateGradient()
 {
-    if ( !m_gradientCache )
-        m_gradientCache = new QRgb[ GradientSize ];
+    m_gradientCache = DataFunctions::sharedGradientCache( m_gradient, DataFunctions::GradientSize );
+}
+
+void ImageView::updateColorTable()
+{
+    if ( m_indexImage.isNull() || m_gradientCache.isEmpty() )
+        return;
 
-    DataFunctions::fillGradientCache( m_gradient, m_gradientCache, GradientSize );
+    QVector<QRgb> table( DataFunctions::ColorTableSize );
+    DataFunctions::fillColorTable( table.data(), m_gradientCache.constData(), m_gradientCache.count(), m_backgroundColor.rgb(),
+        m_colorMapping, m_animationState.scrolling() );
+
+    m_indexImage.setColorTable( table );
 }
 
 void ImageView::updateBackground()
@@ -225,9 +348,18 @@ void ImageView::updateBackground()
 
 void ImageView::updateImage()
 {
+    // previous views no longer match the current colors
+    m_pyramid.clear();
+
     if ( m_image.isNull() )
         return;
 
+    // the generator recolors its own image and delivers it with the following updates
+    if ( m_colorSerial >= 0 ) {
+        updateColorTable();
+        return;
+    }
+
     const FractalData* data = m_presenter->fractalData();
 
     initialUpdate( data );
@@ -254,15 +386,185 @@ void ImageView::calculateScale()
     m_invScale = m_scale.inverted();
 }
 
-void ImageView::paintEvent( QPaintEvent* /*e*/ )
+static const int MaximumLevels = 4;
+
+static double levelScale( const QTransform& transform )
+{
+    return sqrt( fabs( transform.determinant() ) );
+}
+
+void ImageView::storeLevel( const QTransform& transform )
+{
+    // previous views are only used as a background so they are stored at half resolution
+    PyramidLevel level;
+    level.m_image = displayedImage( m_image.rect() ).scaled( m_image.size() / 2, Qt::IgnoreAspectRatio, Qt::SmoothTransformation );
+    if ( level.m_image.isNull() )
+        return;
+
+    level.m_transform = QTransform::fromScale( (double)m_image.width() / level.m_image.width(),
+        (double)m_image.height() / level.m_image.height() ) * transform;
+
+    double scale = levelScale( level.m_transform );
+
+    // replace levels with a similar zoom factor
+    for ( int i = m_pyramid.count() - 1; i >= 0; i-- ) {
+        if ( fabs( log( levelScale( m_pyramid.at( i ).m_transform ) / scale ) ) < log( 2.0 ) )
+            m_pyramid.removeAt( i );
+    }
+
+    // keep the levels ordered from the most zoomed out one
+    int index = 0;
+    while ( index < m_pyramid.count() && levelScale( m_pyramid.at( index ).m_transform ) > scale )
+        index++;
+    m_pyramid.insert( index, level );
+
+    // drop the level which is furthest from the current zoom factor
+    if ( m_pyramid.count() > MaximumLevels ) {
+        if ( fabs( log( levelScale( m_pyramid.first().m_transform ) ) ) > fabs( log( levelScale( m_pyramid.last().m_transform ) ) ) )
+            m_pyramid.removeFirst();
+        else
+            m_pyramid.removeLast();
+    }
+}
+
+void ImageView::transformPyramid( const QTransform& transform )
+{
+    for ( int i = m_pyramid.count() - 1; i >= 0; i-- ) {
+        PyramidLevel& level = m_pyramid[ i ];
+        level.m_transform = level.m_transform * transform;
+
+        // remove levels which are too blurry, too small or no longer visible
+        double scale = levelScale( level.m_transform );
+        QRect rect = level.m_transform.mapRect( level.m_image.rect() );
+        if ( scale > 32.0 || scale < 1.0 / 16.0 || !rect.intersects( QRect( QPoint( 0, 0 ), size() ) ) )
+            m_pyramid.removeAt( i );
+    }
+}
+
+void ImageView::drawPyramid( QPainter* painter, const QTransform& transform, PyramidLevels levels )
+{
+    for ( int i = 0; i < m_pyramid.count(); i++ ) {
+        const PyramidLevel& level = m_pyramid.at( i );
+
+        // levels with scale below 1 have more pixels than the current image
+        bool fine = levelScale( level.m_transform ) < 1.0;
+        if ( fine != ( levels == FineLevels ) )
+            continue;
+
+        painter->setWorldTransform( level.m_transform * transform );
+        painter->drawImage( 0, 0, level.m_image );
+    }
+}
+
+static const int TileSize = 128;
+
+// tiles also contain the first pixels of the next tiles, so that
+// filtering doesn't leave seams when they are scaled or rotated
+static const int TileOverlap = 1;
+
+void ImageView::invalidateTiles( const QRect& rect )
+{
+    int columns = ( m_image.width() + TileSize - 1 ) / TileSize;
+    int rows = ( m_image.height() + TileSize - 1 ) / TileSize;
+
+    if ( columns != m_tileColumns || columns * rows != m_tiles.count() ) {
+        m_tileColumns = columns;
+        m_tiles = QVector<QPixmap>( columns * rows );
+        return;
+    }
+
+    QRect clipped = rect.adjusted( -TileOverlap, -TileOverlap, 0, 0 ).intersected( m_image.rect() );
+    if ( clipped.isEmpty() )
+        return;
+
+    for ( int row = clipped.top() / TileSize; row <= clipped.bottom() / TileSize; row++ ) {
+        for ( int column = clipped.left() / TileSize; column <= clipped.right() / TileSize; column++ )
+            m_tiles[ row * columns + column ] = QPixmap();
+    }
+}
+
+const QPixmap& ImageView::tile( int column, int row )
+{
+    QPixmap& pixmap = m_tiles[ row * m_tileColumns + column ];
+
+    if ( pixmap.isNull() ) {
+        QRect rect( column * TileSize, row * TileSize, TileSize + TileOverlap, TileSize + TileOverlap );
+        pixmap = QPixmap::fromImage( displayedImage( rect.intersected( m_image.rect() ) ) );
+    }
+
+    return pixmap;
+}
+
+void ImageView::paintEvent( QPaintEvent* e )
 {
     if ( m_image.isNull() )
         return;
 
     QPainter painter( this );
-    painter.setRenderHint( QPainter::SmoothPixmapTransform );
-    painter.setWorldTransform( worldTransform() );
-    painter.drawImage( 0, 0, m_image );
+
+    QTransform transform = worldTransform();
+
+    bool pyramid = ( m_tracking != NoTracking && !m_pyramid.isEmpty() );
+
+    if ( pyramid || transform.type() > QTransform::TxTranslate ) {
+        painter.setClipRegion( e->region() );
+        painter.setRenderHint( QPainter::SmoothPixmapTransform );
+    }
+
+    // previous views fill the areas outside of the transformed image
+    if ( pyramid )
+        drawPyramid( &painter, transform, CoarseLevels );
+
+    painter.setWorldTransform( transform );
+
+    // only tiles which intersect the updated region are converted and drawn
+    QRect visible = transform.inverted().mapRect( e->rect() ).intersected( m_image.rect() );
+
+    if ( !visible.isEmpty() ) {
+        // scaled or rotated tiles are drawn with the overlapping pixels, so that
+        // each tile covers the filtered edge of the previous one
+        bool overlap = transform.type() > QTransform::TxTranslate;
+
+        for ( int row = visible.top() / TileSize; row <= visible.bottom() / TileSize; row++ ) {
+            for ( int column = visible.left() / TileSize; column <= visible.right() / TileSize; column++ ) {
+                const QPixmap& pixmap = tile( column, row );
+                QRect source = overlap ? pixmap.rect() : pixmap.rect().intersected( QRect( 0, 0, TileSize, TileSize ) );
+                painter.drawPixmap( QPoint( column * TileSize, row * TileSize ), pixmap, source );
+            }
+        }
+    }
+
+    // previous views with more details are drawn over the upscaled image
+    if ( pyramid )
+        drawPyramid( &painter, transform, FineLevels );
+}
+
+void ImageView::flyStep()
+{
+    // zoom by a factor of ten in two seconds
+    const double flyingSpeed = 2000.0;
+
+    // wait until the previous frame is complete so that the generator can reuse it
+    if ( !m_updatedRegion.contains( m_image.rect() ) )
+        return;
+
+    double direction = ( m_tracking == FlyZoomIn ) ? -1.0 : 1.0;
+    double zoom = pow( 10.0, direction * m_flyTime.restart() / flyingSpeed );
+
+    QTransform transform;
+    transform.translate( m_trackStart.x(), m_trackStart.y() );
+    transform.scale( zoom, zoom );
+    transform.translate( -m_trackStart.x(), -m_trackStart.y() );
+
+    m_presenter->changePosition( m_scale * transform * m_invScale );
+}
+
+void ImageView::stopFlying()
+{
+    if ( m_tracking == FlyZoomIn || m_tracking == FlyZoomOut ) {
+        m_flyTimer->stop();
+        m_presenter->setContinuousZoom( false );
+    }
 }
 
 QTransform ImageView::worldTransform()
@@ -279,6 +581,7 @@ void ImageView::mousePressEvent( QMouseEvent* e )
         return;
 
     if ( m_tracking != NoTracking ) {
+        stopFlying();
         m_tracking = NoTracking;
         m_presenter->clearTracking();
         if ( !m_transform.isIdentity() )
@@ -296,6 +599,17 @@ void ImageView::mousePressEvent( QMouseEvent* e )
     }
 
     m_trackStart = e->pos();
+    m_transform.reset();
+
+    // zoom continuously while the button is held
+    if ( ( e->modifiers() & ( Qt::ShiftModifier | Qt::ControlModifier ) ) == ( Qt::ShiftModifier | Qt::ControlModifier )
+        && ( e->button() == Qt::LeftButton || e->button() == Qt::RightButton ) ) {
+        m_tracking = ( e->button() == Qt::LeftButton ) ? FlyZoomIn : FlyZoomOut;
+        m_presenter->setContinuousZoom( true );
+        m_flyTime.start();
+        m_flyTimer->start();
+        return;
+    }
 
     if ( e->button() == Qt::LeftButton ) {
         if ( e->modifiers() & Qt::ShiftModifier )
@@ -314,8 +628,6 @@ void ImageView::mousePressEvent( QMouseEvent* e )
     } else if ( e->button() == Qt::MidButton ) {
         m_tracking = DragMove;
     }
-
-    m_transform.reset();
 }
 
 void ImageView::mouseMoveEvent( QMouseEvent* e )
@@ -329,6 +641,12 @@ void ImageView::mouseMoveEvent( QMouseEvent* e )
         return;
     }
 
+    // the next step zooms towards the new position
+    if ( m_tracking == FlyZoomIn || m_tracking == FlyZoomOut ) {
+        m_trackStart = e->pos();
+        return;
+    }
+
     const double zoomFactor = 400.0;
     const double rotateFactor = 2.0;
 
@@ -396,6 +714,8 @@ void ImageView::mouseReleaseEvent( QMouseEvent* e )
     if ( !m_interactive || m_tracking == NoTracking || m_image.isNull() )
         return;
 
+    stopFlying();
+
     if ( !m_transform.isIdentity() ) {
         m_presenter->changePosition( m_transform );
         update();
@@ -488,6 +808,7 @@ void ImageView::keyPressEvent( QKeyEvent* e )
 
     if ( e->key() == Qt::Key_Escape && m_tracking != NoTracking ) {
         e->accept();
+        stopFlying();
         m_tracking = NoTracking;
         m_presenter->clearTracking();
         if ( !m_transform.isIdentity() )
@@ -20,10 +20,16 @@
 #define IMAGEVIEW_H
 
 #include <QWidget>
+#include <QVector>
+#include <QPixmap>
+#include <QTime>
 
 #include "abstractview.h"
 #include "datastructures.h"
 
+class QPainter;
+class QTimer;
+
 class FractalPresenter;
 
 class ImageView : public QWidget, public AbstractView
@@ -36,7 +42,7 @@ public:
 public:
     void setInteractive( bool interactive );
 
-    QImage image() const { return m_image; }
+    QImage image() const { return displayedImage( m_image.rect() ); }
 
 public: // AbstractView implementation
     void clearView();
@@ -69,17 +75,47 @@ protected: // overrides
 
     void keyPressEvent( QKeyEvent* e );
 
+private slots:
+    void flyStep();
+
+private:
+    enum PyramidLevels
+    {
+        CoarseLevels,
+        FineLevels
+    };
+
+    struct PyramidLevel
+    {
+        QImage m_image;
+        QTransform m_transform;
+    };
+
 private:
     void updateGradient();
     void updateBackground();
     void updateImage();
+    void updateColorTable();
 
     void drawImage( const FractalData* data, const QRect& region );
+    void copyImage( const FractalData* data, const QRect& region );
+
+    bool isScrolled() const;
+    QImage displayedImage( const QRect& rect ) const;
+
+    void storeLevel( const QTransform& transform );
+    void transformPyramid( const QTransform& transform );
+    void drawPyramid( QPainter* painter, const QTransform& transform, PyramidLevels levels );
+
+    void invalidateTiles( const QRect& rect );
+    const QPixmap& tile( int column, int row );
 
     void calculateScale();
 
     QTransform worldTransform();
 
+    void stopFlying();
+
 private:
     enum Tracking
     {
@@ -90,7 +126,9 @@ private:
         DragZoomOut,
         RotateCenter,
         ZoomCenter,
-        ZoomPoint
+        ZoomPoint,
+        FlyZoomIn,
+        FlyZoomOut
     };
 
 private:
@@ -99,6 +137,13 @@ private:
     bool m_interactive;
 
     QImage m_image;
+    QImage m_backImage;
+    QImage m_indexImage;
+
+    QVector<QPixmap> m_tiles;
+    int m_tileColumns;
+
+    QList<PyramidLevel> m_pyramid;
 
     Gradient m_gradient;
     QColor m_backgroundColor;
@@ -108,9 +153,10 @@ private:
 
     AnimationState m_animationState;
 
-    QRgb* m_gradientCache;
+    QVector<QRgb> m_gradientCache;
 
     QRect m_updatedRegion;
+    int m_colorSerial;
 
     QTransform m_scale;
     QTransform m_invScale;
@@ -118,6 +164,9 @@ private:
     Tracking m_tracking;
     QPoint m_trackStart;
 
+    QTimer* m_flyTimer;
+    QTime m_flyTime;
+
     QTransform m_transform;
 };
 
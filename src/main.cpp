@@ -17,6 +17,8 @@
 **************************************************************************/
 
 #include "fraqtiveapplication.h"
+#include "batchrenderer.h"
+#include "colorbenchmark.h"
 
 #include <QVector>
 
@@ -31,6 +33,25 @@ int main( int argc, char* argv[] )
 {
     qRegisterMetaType<QVector<int> >();
 
-    FraqtiveApplication application( argc, argv );
+    // the benchmark only colors images in memory, so it doesn't need the application
+    if ( ColorBenchmark::isBenchmark( argc, argv ) ) {
+        ColorBenchmark benchmark;
+        return benchmark.exec( argc, argv );
+    }
+
+    // the batch renderer doesn't need a display
+    bool batchMode = BatchRenderer::isBatchMode( argc, argv );
+
+#if ( QT_VERSION >= 0x050000 ) && defined( Q_OS_UNIX ) && !defined( Q_OS_MAC )
+    // Qt 5 always loads a platform plugin, the minimal one doesn't connect to the display
+    if ( batchMode && qgetenv( "QT_QPA_PLATFORM" ).isEmpty() )
+        qputenv( "QT_QPA_PLATFORM", "minimal" );
+#endif
+
+    FraqtiveApplication application( argc, argv, !batchMode );
+
+    if ( batchMode )
+        return application.renderBatch();
+
     return application.exec();
 }
@@ -136,7 +136,13 @@ void MeshView::setColorSettings( const Gradient& gradient, const QColor& backgro
     }
 
     m_backgroundColor = backgroundColor;
-    m_colorMapping = mapping;
+
+    if ( m_colorMapping.transform() != mapping.transform() ) {
+        m_colorMapping = mapping;
+        updateTextureCoords();
+    } else {
+        m_colorMapping = mapping;
+    }
 
     updateGL();
 }
@@ -158,7 +164,12 @@ void MeshView::setBackgroundColor( const QColor& backgroundColor )
 
 void MeshView::setColorMapping( const ColorMapping& mapping )
 {
-    m_colorMapping = mapping;
+    if ( m_colorMapping.transform() != mapping.transform() ) {
+        m_colorMapping = mapping;
+        updateTextureCoords();
+    } else {
+        m_colorMapping = mapping;
+    }
 
     updateGL();
 }
@@ -404,6 +415,8 @@ void MeshView::updateVertices( const FractalData* data, const QRect& region )
     int stride = data->stride();
     int width = region.width();
 
+    ValueTransform transform = m_colorMapping.transform();
+
     for ( int y = region.top(); y <= region.bottom(); y++ ) {
         const double* src = data->buffer() + y * stride + region.left();
         float* vertices = m_vertexArray + y * 3 * width;
@@ -419,7 +432,7 @@ void MeshView::updateVertices( const FractalData* data, const QRect& region )
             else
                 value = InfiniteDepth;
             vertices[ 3 * x + 2 ] = -(float)value;
-            coords[ x ] = (float)value;
+            coords[ x ] = (float)DataFunctions::transformValue( value, transform );
         }
 
         if ( count > 0 )
@@ -439,6 +452,16 @@ void MeshView::updateVertices( const FractalData* data, const QRect& region )
         m_averageHeight = sum / (double)count;
 }
 
+void MeshView::updateTextureCoords()
+{
+    ValueTransform transform = m_colorMapping.transform();
+
+    // the heights of the vertices are the original values
+    int vertices = m_resolution.width() * m_resolution.height();
+    for ( int i = 0; i < vertices; i++ )
+        m_textureCoordArray[ i ] = (float)DataFunctions::transformValue( -m_vertexArray[ 3 * i + 2 ], transform );
+}
+
 void MeshView::mousePressEvent( QMouseEvent* e )
 {
     if ( m_resolution.isEmpty() )
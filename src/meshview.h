@@ -71,6 +71,7 @@ private:
 
     void initializeVertices();
     void updateVertices( const FractalData* data, const QRect& region );
+    void updateTextureCoords();
 
 private:
     enum Tracking
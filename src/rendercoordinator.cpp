@@ -0,0 +1,392 @@
+/**************************************************************************
+* This file is part of the Fraqtive program
+* Copyright (C) 2004-2012 Michał Męciński
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**************************************************************************/
+
+#include "rendercoordinator.h"
+
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QCoreApplication>
+#include <QDataStream>
+
+#include <stdio.h>
+#include <string.h>
+
+#include "tiffwriter.h"
+
+static const int TilesPerWorker = 4;
+static const int MaximumPendingTiles = 4;
+static const int MaximumAttempts = 3;
+
+RenderCoordinator::RenderCoordinator( QObject* parent ) : QObject( parent ),
+    m_workerCount( 1 ),
+    m_server( NULL ),
+    m_restarts( 0 ),
+    m_writer( NULL ),
+    m_nextTile( 0 ),
+    m_finishedTiles( 0 ),
+    m_finished( false ),
+    m_error( false )
+{
+}
+
+RenderCoordinator::~RenderCoordinator()
+{
+    abort();
+}
+
+void RenderCoordinator::setSettings( const TileProtocol::RenderSettings& settings )
+{
+    m_settings = settings;
+}
+
+void RenderCoordinator::setWorkerCount( int count )
+{
+    m_workerCount = count;
+}
+
+QString RenderCoordinator::serverName() const
+{
+    return m_server ? m_server->fullServerName() : QString();
+}
+
+QImage RenderCoordinator::takeImage()
+{
+    QImage result = m_image;
+    m_image = QImage();
+    return result;
+}
+
+bool RenderCoordinator::start()
+{
+    m_image = QImage( m_settings.m_resolution, QImage::Format_RGB32 );
+
+    if ( m_image.isNull() )
+        return false;
+
+    return prepare();
+}
+
+bool RenderCoordinator::startStreaming( TiffWriter* writer )
+{
+    m_image = QImage();
+
+    if ( !prepare() )
+        return false;
+
+    m_writer = writer;
+
+    if ( !writer->open( m_settings.m_resolution, m_tiles.first().height() ) ) {
+        abort();
+        return false;
+    }
+
+    return true;
+}
+
+bool RenderCoordinator::prepare()
+{
+    int width = m_settings.m_resolution.width();
+    int height = m_settings.m_resolution.height();
+
+    // a scan line must fit in the reply of a worker
+    if ( width > TileProtocol::MaximumTilePixels )
+        return false;
+
+    // tiles are horizontal bands so that they can be written to the file in order;
+    // there are several tiles for each worker so that faster workers get more of them
+    int rows = qMax( TileProtocol::MaximumTilePixels / width, 1 );
+    rows = qMin( rows, ( height + TilesPerWorker * m_workerCount - 1 ) / ( TilesPerWorker * m_workerCount ) );
+    rows = qMax( rows, 1 );
+
+    m_tiles.clear();
+    m_pendingTiles.clear();
+
+    for ( int top = 0; top < height; top += rows ) {
+        m_pendingTiles.append( m_tiles.count() );
+        m_tiles.append( QRect( 0, top, width, qMin( rows, height - top ) ) );
+    }
+
+    m_attempts = QVector<int>( m_tiles.count(), 0 );
+
+    m_completedTiles.clear();
+    m_nextTile = 0;
+    m_finishedTiles = 0;
+    m_restarts = 0;
+    m_finished = false;
+    m_error = false;
+    m_writer = NULL;
+
+    m_server = new QLocalServer( this );
+
+    connect( m_server, SIGNAL( newConnection() ), this, SLOT( newConnection() ) );
+
+    QString name = QString( "fraqtive-%1" ).arg( QCoreApplication::applicationPid() );
+
+    if ( !m_server->listen( name ) ) {
+        // remove the socket left by a crashed process with the same identifier
+        QLocalServer::removeServer( name );
+
+        if ( !m_server->listen( name ) )
+            return false;
+    }
+
+    for ( int i = 0; i < m_workerCount; i++ ) {
+        if ( !startWorker() ) {
+            abort();
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void RenderCoordinator::abort()
+{
+    m_finished = true;
+
+    QList<QLocalSocket*> sockets = m_workers.keys();
+    m_workers.clear();
+
+    for ( int i = 0; i < sockets.count(); i++ ) {
+        sockets.at( i )->disconnect( this );
+        sockets.at( i )->abort();
+    }
+
+    for ( int i = 0; i < m_processes.count(); i++ ) {
+        QProcess* process = m_processes.at( i );
+        process->disconnect( this );
+        if ( process->state() != QProcess::NotRunning ) {
+            process->kill();
+            process->waitForFinished( -1 );
+        }
+        delete process;
+    }
+
+    m_processes.clear();
+
+    delete m_server;
+    m_server = NULL;
+}
+
+bool RenderCoordinator::startWorker()
+{
+    QProcess* process = new QProcess( this );
+    process->setProcessChannelMode( QProcess::ForwardedChannels );
+
+    connect( process, SIGNAL( finished( int, QProcess::ExitStatus ) ), this, SLOT( processFinished( int, QProcess::ExitStatus ) ) );
+
+    process->start( QCoreApplication::applicationFilePath(), QStringList() << "--worker" << m_server->fullServerName() );
+
+    m_processes.append( process );
+
+    return process->waitForStarted( -1 );
+}
+
+void RenderCoordinator::newConnection()
+{
+    while ( QLocalSocket* socket = m_server->nextPendingConnection() ) {
+        connect( socket, SIGNAL( readyRead() ), this, SLOT( workerReadyRead() ) );
+        connect( socket, SIGNAL( disconnected() ), this, SLOT( workerDisconnected() ) );
+
+        m_workers.insert( socket, -1 );
+    }
+
+    assignTiles();
+}
+
+void RenderCoordinator::assignTiles()
+{
+    if ( m_finished )
+        return;
+
+    QMap<QLocalSocket*, int>::iterator it;
+    for ( it = m_workers.begin(); it != m_workers.end() && !m_pendingTiles.isEmpty(); ++it ) {
+        if ( it.value() >= 0 )
+            continue;
+
+        // streamed tiles wait in memory until all the tiles above them are written
+        int index = m_pendingTiles.first();
+        if ( m_writer != NULL && index >= m_nextTile + MaximumPendingTiles + m_workerCount )
+            break;
+
+        m_pendingTiles.removeFirst();
+        it.value() = index;
+
+        QByteArray request;
+        QDataStream stream( &request, QIODevice::WriteOnly );
+        stream << (quint8)TileProtocol::RenderTileMessage << (quint32)index << m_tiles.at( index ) << m_settings;
+
+        TileProtocol::sendMessage( it.key(), request );
+    }
+}
+
+void RenderCoordinator::workerReadyRead()
+{
+    QLocalSocket* socket = qobject_cast<QLocalSocket*>( sender() );
+
+    QByteArray reply;
+    while ( !m_finished && m_workers.contains( socket ) ) {
+        TileProtocol::ReceiveStatus status = TileProtocol::receiveMessage( socket, &reply );
+        if ( status == TileProtocol::MessagePending )
+            break;
+
+        // the tile is given to another worker when the socket is disconnected
+        if ( status == TileProtocol::MessageInvalid ) {
+            socket->abort();
+            return;
+        }
+
+        QDataStream stream( reply );
+
+        quint8 type;
+        quint32 id;
+        stream >> type >> id;
+
+        int index = m_workers.value( socket );
+        if ( stream.status() != QDataStream::Ok || (int)id != index ) {
+            socket->abort();
+            return;
+        }
+
+        m_workers[ socket ] = -1;
+
+        if ( type == TileProtocol::TileRenderedMessage ) {
+            QRect region;
+            stream >> region;
+
+            QByteArray pixels = reply.mid( stream.device()->pos() );
+
+            if ( region != m_tiles.at( index ) || pixels.size() != region.width() * region.height() * (int)sizeof( QRgb ) ) {
+                retryTile( index );
+                continue;
+            }
+
+            storeTile( index, pixels );
+        } else {
+            retryTile( index );
+        }
+    }
+
+    assignTiles();
+}
+
+void RenderCoordinator::workerDisconnected()
+{
+    QLocalSocket* socket = qobject_cast<QLocalSocket*>( sender() );
+
+    if ( !m_workers.contains( socket ) )
+        return;
+
+    int index = m_workers.take( socket );
+    socket->deleteLater();
+
+    // the tile of a worker which crashed is given to another worker
+    if ( index >= 0 && !m_finished )
+        retryTile( index );
+
+    assignTiles();
+}
+
+void RenderCoordinator::processFinished( int exitCode, QProcess::ExitStatus exitStatus )
+{
+    if ( m_finished )
+        return;
+
+    QProcess* process = qobject_cast<QProcess*>( sender() );
+    m_processes.removeAll( process );
+    process->deleteLater();
+
+    if ( exitStatus == QProcess::NormalExit && exitCode == 0 )
+        return;
+
+    fprintf( stderr, "fraqtive: worker process failed\n" );
+
+    // crashed workers are replaced while there are tiles left
+    if ( m_restarts < MaximumAttempts * m_workerCount ) {
+        m_restarts++;
+        if ( startWorker() )
+            return;
+    }
+
+    if ( m_processes.isEmpty() )
+        finish( true );
+}
+
+void RenderCoordinator::retryTile( int index )
+{
+    if ( ++m_attempts[ index ] >= MaximumAttempts ) {
+        fprintf( stderr, "fraqtive: tile %d could not be rendered\n", index );
+        finish( true );
+        return;
+    }
+
+    m_pendingTiles.prepend( index );
+}
+
+void RenderCoordinator::storeTile( int index, const QByteArray& pixels )
+{
+    QRect region = m_tiles.at( index );
+
+    // streamed tiles are kept until they can be written, other tiles are copied to the image
+    QImage tile = m_writer ? QImage( region.size(), QImage::Format_RGB32 ) : QImage();
+    QImage& target = m_writer ? tile : m_image;
+    int top = m_writer ? 0 : region.top();
+
+    int bytesPerLine = region.width() * sizeof( QRgb );
+    for ( int y = 0; y < region.height(); y++ )
+        memcpy( target.scanLine( top + y ), pixels.constData() + y * bytesPerLine, bytesPerLine );
+
+    m_finishedTiles++;
+
+    emit progressChanged( m_finishedTiles );
+
+    if ( m_writer ) {
+        m_completedTiles.insert( index, tile );
+        writeTiles();
+    }
+
+    if ( m_finishedTiles == m_tiles.count() )
+        finish( false );
+}
+
+void RenderCoordinator::writeTiles()
+{
+    while ( m_completedTiles.contains( m_nextTile ) ) {
+        if ( !m_writer->writeStrip( m_completedTiles.take( m_nextTile ) ) ) {
+            finish( true );
+            return;
+        }
+        m_nextTile++;
+    }
+}
+
+void RenderCoordinator::finish( bool error )
+{
+    if ( m_finished )
+        return;
+
+    m_finished = true;
+    m_error = error;
+
+    // the workers exit when their connections are closed
+    QList<QLocalSocket*> sockets = m_workers.keys();
+    for ( int i = 0; i < sockets.count(); i++ )
+        sockets.at( i )->disconnectFromServer();
+
+    emit completed();
+}
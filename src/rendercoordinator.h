@@ -0,0 +1,109 @@
+/**************************************************************************
+* This file is part of the Fraqtive program
+* Copyright (C) 2004-2012 Michał Męciński
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**************************************************************************/
+
+#ifndef RENDERCOORDINATOR_H
+#define RENDERCOORDINATOR_H
+
+#include <QObject>
+#include <QImage>
+#include <QProcess>
+#include <QMap>
+#include <QVector>
+
+#include "tileprotocol.h"
+
+class QLocalServer;
+class QLocalSocket;
+class TiffWriter;
+
+// splits an image into tiles and renders them in separate worker processes
+class RenderCoordinator : public QObject
+{
+    Q_OBJECT
+public:
+    RenderCoordinator( QObject* parent );
+    ~RenderCoordinator();
+
+public:
+    void setSettings( const TileProtocol::RenderSettings& settings );
+    void setWorkerCount( int count );
+
+    int maximumProgress() const { return m_tiles.count(); }
+
+    QString serverName() const;
+
+    bool start();
+    bool startStreaming( TiffWriter* writer );
+
+    void abort();
+
+    bool hasError() const { return m_error; }
+
+    QImage takeImage();
+
+signals:
+    void progressChanged( int value );
+    void completed();
+
+private slots:
+    void newConnection();
+    void workerReadyRead();
+    void workerDisconnected();
+    void processFinished( int exitCode, QProcess::ExitStatus exitStatus );
+
+private:
+    bool prepare();
+
+    bool startWorker();
+
+    void assignTiles();
+    void retryTile( int index );
+
+    void storeTile( int index, const QByteArray& pixels );
+    void writeTiles();
+
+    void finish( bool error );
+
+private:
+    TileProtocol::RenderSettings m_settings;
+    int m_workerCount;
+
+    QLocalServer* m_server;
+
+    QList<QProcess*> m_processes;
+    int m_restarts;
+
+    QMap<QLocalSocket*, int> m_workers;
+
+    QVector<QRect> m_tiles;
+    QVector<int> m_attempts;
+    QList<int> m_pendingTiles;
+
+    QImage m_image;
+
+    TiffWriter* m_writer;
+    QMap<int, QImage> m_completedTiles;
+    int m_nextTile;
+
+    int m_finishedTiles;
+
+    bool m_finished;
+    bool m_error;
+};
+
+#endif
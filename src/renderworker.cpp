@@ -0,0 +1,118 @@
+/**************************************************************************
+* This file is part of the Fraqtive program
+* Copyright (C) 2004-2012 Michał Męciński
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**************************************************************************/
+
+#include "renderworker.h"
+
+#include <QLocalSocket>
+#include <QDataStream>
+#include <QEventLoop>
+
+#include <stdio.h>
+
+#include "imagegenerator.h"
+
+static const int ConnectTimeout = 30000;
+
+RenderWorker::RenderWorker( QObject* parent ) : QObject( parent )
+{
+}
+
+RenderWorker::~RenderWorker()
+{
+}
+
+int RenderWorker::exec( const QString& serverName )
+{
+    QLocalSocket socket;
+    socket.connectToServer( serverName );
+
+    if ( !socket.waitForConnected( ConnectTimeout ) ) {
+        fprintf( stderr, "fraqtive: cannot connect to %s\n", qPrintable( serverName ) );
+        return 1;
+    }
+
+    for ( ;; ) {
+        QByteArray request;
+
+        // the coordinator closes the connection when all tiles are rendered
+        TileProtocol::ReceiveStatus status;
+        while ( ( status = TileProtocol::receiveMessage( &socket, &request ) ) == TileProtocol::MessagePending ) {
+            if ( !socket.waitForReadyRead( -1 ) )
+                return socket.state() == QLocalSocket::UnconnectedState ? 0 : 1;
+        }
+
+        if ( status == TileProtocol::MessageInvalid )
+            return 1;
+
+        QDataStream input( request );
+
+        quint8 type;
+        quint32 id;
+        QRect region;
+        TileProtocol::RenderSettings settings;
+
+        input >> type >> id >> region >> settings;
+
+        if ( input.status() != QDataStream::Ok || type != TileProtocol::RenderTileMessage )
+            return 1;
+
+        QImage image = renderTile( region, settings );
+
+        QByteArray reply;
+        QDataStream output( &reply, QIODevice::WriteOnly );
+
+        // the pixels are sent as raw scan lines in the native format of the image
+        if ( image.isNull() ) {
+            output << (quint8)TileProtocol::TileFailedMessage << id;
+        } else {
+            output << (quint8)TileProtocol::TileRenderedMessage << id << region;
+            output.writeRawData( reinterpret_cast<const char*>( image.bits() ), image.byteCount() );
+        }
+
+        TileProtocol::sendMessage( &socket, reply );
+
+        while ( socket.bytesToWrite() > 0 ) {
+            if ( !socket.waitForBytesWritten( -1 ) )
+                return 1;
+        }
+    }
+}
+
+QImage RenderWorker::renderTile( const QRect& region, const TileProtocol::RenderSettings& settings )
+{
+    ImageGenerator generator( this );
+    generator.setResolution( settings.m_resolution );
+    generator.setMultiSampling( settings.m_multiSampling );
+    generator.setAdaptiveSampling( settings.m_adaptive );
+    generator.setRegion( region );
+    generator.setParameters( settings.m_type, settings.m_position );
+    generator.setColorSettings( settings.m_gradient, settings.m_backgroundColor, settings.m_colorMapping );
+    generator.setGeneratorSettings( settings.m_generatorSettings );
+    generator.setViewSettings( settings.m_viewSettings );
+
+    QEventLoop eventLoop;
+
+    connect( &generator, SIGNAL( completed() ), &eventLoop, SLOT( quit() ), Qt::QueuedConnection );
+
+    if ( !generator.start() )
+        return QImage();
+
+    eventLoop.exec();
+
+    return generator.takeImage();
+}
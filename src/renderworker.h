@@ -0,0 +1,44 @@
+/**************************************************************************
+* This file is part of the Fraqtive program
+* Copyright (C) 2004-2012 Michał Męciński
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**************************************************************************/
+
+#ifndef RENDERWORKER_H
+#define RENDERWORKER_H
+
+#include <QObject>
+#include <QImage>
+
+#include "tileprotocol.h"
+
+class QLocalSocket;
+
+// renders tiles requested by a coordinator process until it disconnects
+class RenderWorker : public QObject
+{
+    Q_OBJECT
+public:
+    RenderWorker( QObject* parent );
+    ~RenderWorker();
+
+public:
+    int exec( const QString& serverName );
+
+private:
+    QImage renderTile( const QRect& region, const TileProtocol::RenderSettings& settings );
+};
+
+#endif
@@ -0,0 +1,501 @@
+/**************************************************************************
+* This file is part of the Fraqtive program
+* Copyright (C) 2004-2012 Michał Męciński
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**************************************************************************/
+
+#include "seriesgenerator.h"
+
+#include <math.h>
+
+#include <QDataStream>
+#include <QDir>
+#include <QFileInfo>
+#include <QThread>
+
+#include "checkpoint.h"
+#include "exponentialmap.h"
+#include "imagegenerator.h"
+#include "serieswriter.h"
+#include "videowriter.h"
+
+SeriesGenerator::SeriesGenerator( QObject* parent ) : QObject( parent ),
+    m_multiSampling( 0 ),
+    m_adaptive( false ),
+    m_images( 0 ),
+    m_zoomFactor( 0.0 ),
+    m_angle( 0.0 ),
+    m_blending( 0.0 ),
+    m_exponentialMap( false ),
+    m_map( NULL ),
+    m_mapProgress( 0 ),
+    m_mapReady( false ),
+    m_mapImages( 0 ),
+    m_writer( NULL ),
+    m_checkpoint( NULL ),
+    m_writtenImages( 0 ),
+    m_imageProgress( 0 ),
+    m_maximumImages( 0 ),
+    m_nextImage( 0 ),
+    m_nextOutput( 0 ),
+    m_finishedImages( 0 ),
+    m_finishing( false ),
+    m_error( NoError )
+{
+}
+
+SeriesGenerator::~SeriesGenerator()
+{
+    // the generators wait for their jobs and the writer for the current image
+    qDeleteAll( m_generators );
+    delete m_map;
+    delete m_writer;
+}
+
+void SeriesGenerator::setResolution( const QSize& resolution )
+{
+    m_resolution = resolution;
+}
+
+void SeriesGenerator::setMultiSampling( int multiSampling, bool adaptive )
+{
+    m_multiSampling = multiSampling;
+    m_adaptive = adaptive;
+}
+
+void SeriesGenerator::setParameters( const FractalType& type, const Position& position )
+{
+    m_type = type;
+    m_position = position;
+}
+
+void SeriesGenerator::setAnimation( int images, double zoomFactor, double angle, double blending )
+{
+    m_images = images;
+    m_zoomFactor = zoomFactor;
+    m_angle = angle;
+    m_blending = blending;
+}
+
+void SeriesGenerator::setExponentialMap( bool enabled )
+{
+    m_exponentialMap = enabled;
+}
+
+void SeriesGenerator::setColorSettings( const Gradient& gradient, const QColor& backgroundColor, const ColorMapping& mapping )
+{
+    m_gradient = gradient;
+    m_backgroundColor = backgroundColor;
+    m_colorMapping = mapping;
+}
+
+void SeriesGenerator::setGeneratorSettings( const GeneratorSettings& settings )
+{
+    m_generatorSettings = settings;
+}
+
+void SeriesGenerator::setViewSettings( const ViewSettings& settings )
+{
+    m_viewSettings = settings;
+}
+
+void SeriesGenerator::setOutput( const QString& fileName, const QByteArray& format, const QString& encoder )
+{
+    m_fileName = fileName;
+    m_format = format;
+    m_encoder = encoder;
+}
+
+void SeriesGenerator::setCheckpoint( Checkpoint* checkpoint )
+{
+    m_checkpoint = checkpoint;
+}
+
+bool SeriesGenerator::canResume()
+{
+    // a video stream cannot be continued
+    if ( !m_checkpoint || VideoWriter::isVideoFormat( m_format ) )
+        return false;
+
+    m_checkpoint->setParameters( checkpointParameters() );
+
+    return m_checkpoint->load() && m_checkpoint->progress() < m_images;
+}
+
+int SeriesGenerator::maximumProgress() const
+{
+    return ( m_map ? m_map->maximumProgress() : 0 ) + m_imageProgress * m_images;
+}
+
+static const qint64 MaximumMemory = 256 * 1024 * 1024;
+static const int MaximumGenerators = 8;
+
+bool SeriesGenerator::start( bool resume /*= false*/ )
+{
+    m_writer = new SeriesWriter( this );
+    m_writer->setFormat( m_format );
+    m_writer->setVideoOutput( m_fileName, m_encoder );
+
+    double angle = m_angle / (double)( m_images - 1 );
+    double scale = pow( 10.0, m_zoomFactor / (double)( m_images - 1 ) );
+    m_writer->setBlending( m_blending, angle, scale );
+
+    connect( m_writer, SIGNAL( imageWritten() ), this, SLOT( imageWritten() ), Qt::QueuedConnection );
+
+    int firstImage = 0;
+
+    // images which were already written are not calculated again
+    if ( resume && canResume() ) {
+        firstImage = m_checkpoint->progress();
+
+        // the next image is blended with the last written one
+        if ( m_blending > 0.01 ) {
+            QImage previous( imagePath( firstImage - 1 ) );
+            if ( !previous.isNull() )
+                m_writer->setPreviousImage( previous.convertToFormat( QImage::Format_RGB32 ) );
+            else
+                firstImage = 0;
+        }
+    }
+
+    if ( VideoWriter::isVideoFormat( m_format ) )
+        m_checkpoint = NULL;
+
+    if ( m_checkpoint )
+        m_checkpoint->setParameters( checkpointParameters() );
+
+    m_nextImage = firstImage;
+    m_nextOutput = firstImage;
+    m_finishedImages = firstImage;
+    m_writtenImages = firstImage;
+
+    // images which are calculated, waiting for the previous images or being saved are limited by memory
+    qint64 imageSize = (qint64)m_resolution.width() * m_resolution.height() * sizeof( QRgb );
+    m_maximumImages = (int)qBound( (qint64)2, MaximumMemory / imageSize, (qint64)m_images );
+
+    if ( m_exponentialMap ) {
+        m_map = new ExponentialMap( this );
+        m_map->setResolution( m_resolution, m_multiSampling );
+        m_map->setParameters( m_type, m_position );
+        m_map->setZoomRange( imagePosition( 0 ).zoomFactor(), imagePosition( m_images - 1 ).zoomFactor() );
+        m_map->setColorSettings( m_gradient, m_backgroundColor, m_colorMapping );
+        m_map->setGeneratorSettings( m_generatorSettings );
+
+        // each image is calculated separately when the strip would not be smaller than the images
+        if ( !m_map->isEfficient( m_images ) ) {
+            delete m_map;
+            m_map = NULL;
+        }
+    }
+
+    if ( m_map ) {
+        connect( m_map, SIGNAL( progressChanged( int ) ), this, SLOT( mapProgress( int ) ), Qt::QueuedConnection );
+        connect( m_map, SIGNAL( completed() ), this, SLOT( mapCompleted() ), Qt::QueuedConnection );
+        connect( m_map, SIGNAL( imageCompleted( int, const QImage& ) ), this, SLOT( mapImageCompleted( int, const QImage& ) ), Qt::QueuedConnection );
+
+        // rendering an image from the strip is a single job
+        m_imageProgress = 1;
+
+        if ( !m_map->start() )
+            return false;
+
+        m_writer->start();
+
+        return true;
+    }
+
+    ImageGenerator* generator = new ImageGenerator( this );
+    generator->setResolution( m_resolution );
+    generator->setMultiSampling( m_multiSampling );
+    generator->setAdaptiveSampling( m_adaptive );
+
+    m_imageProgress = generator->maximumProgress();
+
+    delete generator;
+
+    // small images have fewer jobs than threads, so several of them are calculated at once
+    int threads = QThread::idealThreadCount();
+    int count = qBound( 1, ( threads + m_imageProgress - 1 ) / m_imageProgress + 1, qMin( MaximumGenerators, m_maximumImages ) );
+
+    for ( int i = 0; i < count; i++ ) {
+        generator = new ImageGenerator( this );
+        generator->setResolution( m_resolution );
+        generator->setMultiSampling( m_multiSampling );
+        generator->setAdaptiveSampling( m_adaptive );
+        generator->setColorSettings( m_gradient, m_backgroundColor, m_colorMapping );
+        generator->setGeneratorSettings( m_generatorSettings );
+        generator->setViewSettings( m_viewSettings );
+
+        connect( generator, SIGNAL( progressChanged( int ) ), this, SLOT( generatorProgress( int ) ), Qt::QueuedConnection );
+        connect( generator, SIGNAL( completed() ), this, SLOT( generatorCompleted() ), Qt::QueuedConnection );
+
+        m_generators.append( generator );
+    }
+
+    m_generatorImages = QVector<int>( count, -1 );
+    m_generatorProgress = QVector<int>( count, 0 );
+
+    m_writer->start();
+
+    startImages();
+
+    return m_error == NoError;
+}
+
+void SeriesGenerator::cancel()
+{
+    abort( NoError );
+}
+
+void SeriesGenerator::generatorProgress( int value )
+{
+    if ( m_finishing )
+        return;
+
+    int index = m_generators.indexOf( static_cast<ImageGenerator*>( sender() ) );
+    if ( index < 0 || m_generatorImages.at( index ) < 0 )
+        return;
+
+    m_generatorProgress[ index ] = value;
+
+    updateProgress();
+}
+
+void SeriesGenerator::generatorCompleted()
+{
+    if ( m_finishing )
+        return;
+
+    int index = m_generators.indexOf( static_cast<ImageGenerator*>( sender() ) );
+    if ( index < 0 || m_generatorImages.at( index ) < 0 )
+        return;
+
+    int image = m_generatorImages.at( index );
+
+    m_generatorImages[ index ] = -1;
+    m_generatorProgress[ index ] = 0;
+
+    addImage( image, m_generators.at( index )->takeImage() );
+}
+
+void SeriesGenerator::imageWritten()
+{
+    if ( m_finishing )
+        return;
+
+    if ( m_writer->hasError() ) {
+        abort( FileError );
+        return;
+    }
+
+    // the written images are recorded from time to time so that the series can be resumed
+    if ( m_checkpoint && m_writtenImages < m_images ) {
+        m_writtenImages++;
+
+        if ( m_writtenImages < m_images && m_checkpoint->isDue() )
+            m_checkpoint->save( m_writtenImages );
+    }
+
+    if ( m_nextOutput == m_images && m_writer->pendingImages() == 0 ) {
+        m_finishing = true;
+        emit completed();
+        return;
+    }
+
+    startImages();
+}
+
+void SeriesGenerator::mapProgress( int value )
+{
+    if ( m_finishing )
+        return;
+
+    m_mapProgress = value;
+
+    updateProgress();
+}
+
+void SeriesGenerator::mapCompleted()
+{
+    if ( m_finishing )
+        return;
+
+    m_mapReady = true;
+
+    startImages();
+}
+
+void SeriesGenerator::mapImageCompleted( int index, const QImage& image )
+{
+    if ( m_finishing )
+        return;
+
+    m_mapImages--;
+
+    if ( image.isNull() ) {
+        abort( MemoryError );
+        return;
+    }
+
+    addImage( index, image );
+}
+
+void SeriesGenerator::startImages()
+{
+    if ( m_map ) {
+        if ( !m_mapReady )
+            return;
+
+        // only a few images are rendered from the strip at once
+        int threads = QThread::idealThreadCount();
+
+        while ( m_nextImage < m_images && m_mapImages < threads && heldImages() < m_maximumImages ) {
+            m_map->addImage( m_nextImage, imagePosition( m_nextImage ) );
+            m_nextImage++;
+            m_mapImages++;
+        }
+
+        return;
+    }
+
+    for ( int i = 0; i < m_generators.count() && m_nextImage < m_images; i++ ) {
+        if ( m_generatorImages.at( i ) >= 0 )
+            continue;
+
+        if ( heldImages() >= m_maximumImages )
+            break;
+
+        ImageGenerator* generator = m_generators.at( i );
+        generator->setParameters( m_type, imagePosition( m_nextImage ) );
+
+        if ( !generator->start() ) {
+            abort( MemoryError );
+            return;
+        }
+
+        m_generatorImages[ i ] = m_nextImage++;
+    }
+}
+
+void SeriesGenerator::addImage( int index, const QImage& image )
+{
+    m_completedImages.insert( index, image );
+
+    m_finishedImages++;
+
+    updateProgress();
+
+    writeImages();
+    startImages();
+}
+
+void SeriesGenerator::writeImages()
+{
+    // images are blended in order, so they are passed to the writer in order
+    while ( m_completedImages.contains( m_nextOutput ) ) {
+        m_writer->addImage( m_completedImages.take( m_nextOutput ), imagePath( m_nextOutput ) );
+        m_nextOutput++;
+    }
+
+    if ( m_nextOutput == m_images )
+        m_writer->finish();
+}
+
+void SeriesGenerator::abort( Error error )
+{
+    if ( m_finishing )
+        return;
+
+    m_finishing = true;
+    m_error = error;
+
+    for ( int i = 0; i < m_generators.count(); i++ )
+        m_generators.at( i )->abort();
+
+    if ( m_map )
+        m_map->abort();
+
+    m_writer->cancel();
+
+    m_completedImages.clear();
+
+    // an interrupted series can be continued from the last written image
+    if ( m_checkpoint && m_writtenImages > 0 && m_writtenImages < m_images )
+        m_checkpoint->save( m_writtenImages );
+
+    if ( error != NoError )
+        emit completed();
+}
+
+Position SeriesGenerator::imagePosition( int index ) const
+{
+    Position position = m_position;
+
+    double zoomTo = position.zoomFactor();
+    double zoomFrom = zoomTo - m_zoomFactor;
+    double angleTo = position.angle();
+    double angleFrom = angleTo - m_angle;
+
+    double a = (double)index / (double)( m_images - 1 );
+
+    position.setZoomFactor( zoomFrom + a * ( zoomTo - zoomFrom ) );
+    position.setAngle( angleFrom + a * ( angleTo - angleFrom ) );
+
+    return position;
+}
+
+QString SeriesGenerator::imagePath( int index ) const
+{
+    QFileInfo info( m_fileName );
+
+    QString fullName = info.completeBaseName() + QLatin1String( "." ) + QString::number( index ).rightJustified( 4, QLatin1Char( '0' ) ) + QLatin1String( "." ) + info.suffix();
+
+    return info.absoluteDir().absoluteFilePath( fullName );
+}
+
+QByteArray SeriesGenerator::checkpointParameters() const
+{
+    QByteArray parameters;
+    QDataStream stream( &parameters, QIODevice::WriteOnly );
+
+    stream << m_resolution << (qint32)m_multiSampling << m_adaptive << m_type << m_position
+        << (qint32)m_images << m_zoomFactor << m_angle << m_blending << m_exponentialMap
+        << m_gradient << m_backgroundColor << m_colorMapping << m_generatorSettings << m_viewSettings
+        << m_fileName << m_format;
+
+    return parameters;
+}
+
+int SeriesGenerator::heldImages() const
+{
+    int count = m_completedImages.count() + m_writer->pendingImages() + m_mapImages;
+
+    for ( int i = 0; i < m_generatorImages.count(); i++ ) {
+        if ( m_generatorImages.at( i ) >= 0 )
+            count++;
+    }
+
+    return count;
+}
+
+void SeriesGenerator::updateProgress()
+{
+    int progress = m_mapProgress + m_imageProgress * m_finishedImages;
+
+    for ( int i = 0; i < m_generatorProgress.count(); i++ )
+        progress += m_generatorProgress.at( i );
+
+    emit progressChanged( progress );
+}
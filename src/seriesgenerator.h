@@ -0,0 +1,153 @@
+/**************************************************************************
+* This file is part of the Fraqtive program
+* Copyright (C) 2004-2012 Michał Męciński
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**************************************************************************/
+
+#ifndef SERIESGENERATOR_H
+#define SERIESGENERATOR_H
+
+#include <QObject>
+#include <QImage>
+#include <QMap>
+#include <QVector>
+
+#include "datastructures.h"
+
+class Checkpoint;
+class ExponentialMap;
+class ImageGenerator;
+class SeriesWriter;
+
+class SeriesGenerator : public QObject
+{
+    Q_OBJECT
+public:
+    enum Error
+    {
+        NoError,
+        MemoryError,
+        FileError
+    };
+
+public:
+    SeriesGenerator( QObject* parent );
+    ~SeriesGenerator();
+
+public:
+    void setResolution( const QSize& resolution );
+    void setMultiSampling( int multiSampling, bool adaptive );
+    void setParameters( const FractalType& type, const Position& position );
+    void setAnimation( int images, double zoomFactor, double angle, double blending );
+    void setExponentialMap( bool enabled );
+    void setColorSettings( const Gradient& gradient, const QColor& backgroundColor, const ColorMapping& mapping );
+    void setGeneratorSettings( const GeneratorSettings& settings );
+    void setViewSettings( const ViewSettings& settings );
+
+    void setOutput( const QString& fileName, const QByteArray& format, const QString& encoder );
+
+    void setCheckpoint( Checkpoint* checkpoint );
+    bool canResume();
+
+    int maximumProgress() const;
+
+    bool start( bool resume = false );
+    void cancel();
+
+    Error error() const { return m_error; }
+
+signals:
+    void progressChanged( int value );
+    void completed();
+
+private slots:
+    void generatorProgress( int value );
+    void generatorCompleted();
+    void imageWritten();
+
+    void mapProgress( int value );
+    void mapCompleted();
+    void mapImageCompleted( int index, const QImage& image );
+
+private:
+    void startImages();
+    void addImage( int index, const QImage& image );
+    void writeImages();
+
+    void abort( Error error );
+
+    Position imagePosition( int index ) const;
+    QString imagePath( int index ) const;
+
+    int heldImages() const;
+
+    QByteArray checkpointParameters() const;
+
+    void updateProgress();
+
+private:
+    QSize m_resolution;
+    int m_multiSampling;
+    bool m_adaptive;
+
+    FractalType m_type;
+    Position m_position;
+
+    int m_images;
+    double m_zoomFactor;
+    double m_angle;
+    double m_blending;
+
+    bool m_exponentialMap;
+
+    Gradient m_gradient;
+    QColor m_backgroundColor;
+    ColorMapping m_colorMapping;
+
+    GeneratorSettings m_generatorSettings;
+    ViewSettings m_viewSettings;
+
+    QString m_fileName;
+    QByteArray m_format;
+    QString m_encoder;
+
+    QList<ImageGenerator*> m_generators;
+    QVector<int> m_generatorImages;
+    QVector<int> m_generatorProgress;
+
+    ExponentialMap* m_map;
+    int m_mapProgress;
+    bool m_mapReady;
+    int m_mapImages;
+
+    SeriesWriter* m_writer;
+
+    Checkpoint* m_checkpoint;
+    int m_writtenImages;
+
+    int m_imageProgress;
+    int m_maximumImages;
+
+    int m_nextImage;
+    int m_nextOutput;
+    int m_finishedImages;
+
+    QMap<int, QImage> m_completedImages;
+
+    bool m_finishing;
+    Error m_error;
+};
+
+#endif
@@ -0,0 +1,229 @@
+/**************************************************************************
+* This file is part of the Fraqtive program
+* Copyright (C) 2004-2012 Michał Męciński
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**************************************************************************/
+
+#include "serieswriter.h"
+
+#include <QImageWriter>
+#include <QPainter>
+
+#include "videowriter.h"
+
+SeriesWriter::SeriesWriter( QObject* parent ) : QThread( parent ),
+    m_video( NULL ),
+    m_blending( 0.0 ),
+    m_angle( 0.0 ),
+    m_scale( 1.0 ),
+    m_pendingImages( 0 ),
+    m_finishing( false ),
+    m_closing( false ),
+    m_error( false )
+{
+}
+
+SeriesWriter::~SeriesWriter()
+{
+    cancel();
+    wait();
+}
+
+void SeriesWriter::setFormat( const QByteArray& format )
+{
+    m_format = format;
+}
+
+void SeriesWriter::setVideoOutput( const QString& fileName, const QString& encoder )
+{
+    m_videoFileName = fileName;
+    m_encoder = encoder;
+}
+
+void SeriesWriter::setBlending( double blending, double angle, double scale )
+{
+    m_blending = blending;
+    m_angle = angle;
+    m_scale = scale;
+}
+
+void SeriesWriter::setPreviousImage( const QImage& image )
+{
+    m_previous = image;
+}
+
+void SeriesWriter::addImage( const QImage& image, const QString& path )
+{
+    QMutexLocker locker( &m_mutex );
+
+    m_images.append( image );
+    m_paths.append( path );
+
+    m_pendingImages++;
+
+    m_hasPendingImages.wakeAll();
+}
+
+int SeriesWriter::pendingImages()
+{
+    QMutexLocker locker( &m_mutex );
+
+    return m_pendingImages;
+}
+
+bool SeriesWriter::hasError()
+{
+    QMutexLocker locker( &m_mutex );
+
+    return m_error;
+}
+
+void SeriesWriter::finish()
+{
+    QMutexLocker locker( &m_mutex );
+
+    m_finishing = true;
+
+    // closing the video counts as a pending image so that it completes before the series
+    if ( VideoWriter::isVideoFormat( m_format ) ) {
+        m_closing = true;
+        m_pendingImages++;
+    }
+
+    m_hasPendingImages.wakeAll();
+}
+
+void SeriesWriter::cancel()
+{
+    QMutexLocker locker( &m_mutex );
+
+    m_pendingImages -= m_images.count();
+
+    m_images.clear();
+    m_paths.clear();
+
+    if ( m_closing ) {
+        m_closing = false;
+        m_pendingImages--;
+    }
+
+    m_finishing = true;
+
+    m_hasPendingImages.wakeAll();
+}
+
+void SeriesWriter::run()
+{
+    QMutexLocker locker( &m_mutex );
+
+    for ( ;; ) {
+        while ( m_images.isEmpty() && !m_finishing )
+            m_hasPendingImages.wait( &m_mutex );
+
+        if ( m_images.isEmpty() )
+            break;
+
+        QImage image = m_images.takeFirst();
+        QString path = m_paths.takeFirst();
+
+        locker.unlock();
+
+        bool written = writeImage( image, path );
+
+        locker.relock();
+
+        m_pendingImages--;
+
+        // the remaining images are dropped when one of them cannot be written
+        if ( !written ) {
+            m_error = true;
+            m_pendingImages -= m_images.count();
+            m_images.clear();
+            m_paths.clear();
+        }
+
+        emit imageWritten();
+
+        if ( m_error )
+            break;
+    }
+
+    if ( m_closing && !m_error ) {
+        bool closed = true;
+
+        if ( m_video != NULL ) {
+            locker.unlock();
+
+            closed = m_video->close();
+
+            locker.relock();
+        }
+
+        if ( m_closing ) {
+            m_closing = false;
+            m_pendingImages--;
+
+            if ( !closed )
+                m_error = true;
+
+            emit imageWritten();
+        }
+    }
+
+    // an unfinished video is discarded
+    delete m_video;
+    m_video = NULL;
+}
+
+bool SeriesWriter::writeImage( QImage image, const QString& path )
+{
+    if ( !m_previous.isNull() ) {
+        QPainter painter( &image );
+
+        QTransform transform;
+        transform.translate( image.width() / 2, image.height() / 2 );
+        transform.rotate( m_angle );
+        transform.scale( m_scale, m_scale );
+        transform.translate( -image.width() / 2, -image.height() / 2 );
+
+        painter.setOpacity( m_blending );
+        painter.setTransform( transform );
+        painter.setRenderHint( QPainter::SmoothPixmapTransform );
+
+        painter.drawImage( 0, 0, m_previous );
+    }
+
+    // the next image is blended with this image including its own blending
+    if ( m_blending > 0.01 )
+        m_previous = image;
+
+    if ( VideoWriter::isVideoFormat( m_format ) ) {
+        if ( m_video == NULL ) {
+            m_video = new VideoWriter( m_videoFileName, m_format, m_encoder );
+
+            if ( !m_video->open( image.size() ) )
+                return false;
+        }
+
+        return m_video->writeFrame( image );
+    }
+
+    QImageWriter writer( path, m_format );
+
+    if ( m_format == "tiff" )
+        writer.setCompression( 1 );
+
+    return writer.write( image );
+}
@@ -0,0 +1,88 @@
+/**************************************************************************
+* This file is part of the Fraqtive program
+* Copyright (C) 2004-2012 Michał Męciński
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**************************************************************************/
+
+#ifndef SERIESWRITER_H
+#define SERIESWRITER_H
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QImage>
+#include <QStringList>
+
+class VideoWriter;
+
+class SeriesWriter : public QThread
+{
+    Q_OBJECT
+public:
+    SeriesWriter( QObject* parent );
+    ~SeriesWriter();
+
+public:
+    void setFormat( const QByteArray& format );
+    void setVideoOutput( const QString& fileName, const QString& encoder );
+    void setBlending( double blending, double angle, double scale );
+    void setPreviousImage( const QImage& image );
+
+    void addImage( const QImage& image, const QString& path );
+
+    int pendingImages();
+
+    bool hasError();
+
+    void finish();
+    void cancel();
+
+public: // overrides
+    void run();
+
+signals:
+    void imageWritten();
+
+private:
+    bool writeImage( QImage image, const QString& path );
+
+private:
+    QByteArray m_format;
+
+    QString m_videoFileName;
+    QString m_encoder;
+
+    VideoWriter* m_video;
+
+    double m_blending;
+    double m_angle;
+    double m_scale;
+
+    QImage m_previous;
+
+    QMutex m_mutex;
+    QWaitCondition m_hasPendingImages;
+
+    QList<QImage> m_images;
+    QStringList m_paths;
+
+    int m_pendingImages;
+
+    bool m_finishing;
+    bool m_closing;
+    bool m_error;
+};
+
+#endif
@@ -3,15 +3,18 @@ include( ../config.pri )
 TEMPLATE = app
 TARGET = fraqtive
 
-QT += opengl xml
+QT += opengl xml network
 
 HEADERS   += aboutbox.h \
              abstractjobprovider.h \
              abstractview.h \
              advancedsettingspage.h \
              animationpage.h \
+             batchrenderer.h \
              bookmarklistview.h \
              bookmarkmodel.h \
+             checkpoint.h \
+             colorbenchmark.h \
              colorsettingspage.h \
              colorwidget.h \
              configurationdata.h \
@@ -19,6 +22,7 @@ HEADERS   += aboutbox.h \
              datastructures.h \
              doubleedit.h \
              doubleslider.h \
+             exponentialmap.h \
              fractaldata.h \
              fractalgenerator.h \
              fractalmodel.h \
@@ -33,6 +37,7 @@ HEADERS   += aboutbox.h \
              gradientdialog.h \
              gradienteditor.h \
              guidedialog.h \
+             histogramwidget.h \
              iconloader.h \
              imagegenerator.h \
              imageview.h \
@@ -45,23 +50,33 @@ HEADERS   += aboutbox.h \
              presetmodel.h \
              propertytoolbox.h \
              renamedialog.h \
+             rendercoordinator.h \
+             renderworker.h \
              savebookmarkdialog.h \
              savepresetdialog.h \
+             seriesgenerator.h \
+             serieswriter.h \
              shadewidget.h \
+             tiffwriter.h \
+             tileprotocol.h \
+             videowriter.h \
              viewcontainer.h
 
 SOURCES   += aboutbox.cpp \
              advancedsettingspage.cpp \
              animationpage.cpp \
+             batchrenderer.cpp \
              bookmarklistview.cpp \
              bookmarkmodel.cpp \
+             checkpoint.cpp \
+             colorbenchmark.cpp \
              colorsettingspage.cpp \
              colorwidget.cpp \
              configurationdata.cpp \
-             datafunctions.cpp \
              datastructures.cpp \
              doubleedit.cpp \
              doubleslider.cpp \
+             exponentialmap.cpp \
              fractaldata.cpp \
              fractalgenerator.cpp \
              fractalmodel.cpp \
@@ -75,6 +90,7 @@ SOURCES   += aboutbox.cpp \
              gradientdialog.cpp \
              gradienteditor.cpp \
              guidedialog.cpp \
+             histogramwidget.cpp \
              iconloader.cpp \
              imagegenerator.cpp \
              imageview.cpp \
@@ -88,9 +104,16 @@ SOURCES   += aboutbox.cpp \
              presetmodel.cpp \
              propertytoolbox.cpp \
              renamedialog.cpp \
+             rendercoordinator.cpp \
+             renderworker.cpp \
              savebookmarkdialog.cpp \
              savepresetdialog.cpp \
+             seriesgenerator.cpp \
+             serieswriter.cpp \
              shadewidget.cpp \
+             tiffwriter.cpp \
+             tileprotocol.cpp \
+             videowriter.cpp \
              viewcontainer.cpp
 
 FORMS     += advancedsettingspage.ui \
@@ -120,7 +143,8 @@ no-sse2|win32-msvc|win32-g++: CONFIG -= sse2
 sse2 {
     DEFINES += HAVE_SSE2
     win32-g++|!win32:!*-icc* {
-        SSE2_SOURCES += generatorcore.cpp
+        SSE2_SOURCES += datafunctions.cpp \
+                        generatorcore.cpp
         sse2_compiler.commands = $$QMAKE_CXX -c -msse2 $(CXXFLAGS) $(INCPATH) ${QMAKE_FILE_IN} -o ${QMAKE_FILE_OUT}
         sse2_compiler.dependency_type = TYPE_C
         sse2_compiler.output = ${QMAKE_VAR_OBJECTS_DIR}${QMAKE_FILE_BASE}$${first(QMAKE_EXT_OBJ)}
@@ -130,10 +154,27 @@ sse2 {
         silent:sse2_compiler.commands = @echo compiling[sse2] ${QMAKE_FILE_IN} && $$sse2_compiler.commands
         QMAKE_EXTRA_COMPILERS += sse2_compiler
     } else {
-        SOURCES += generatorcore.cpp
+        SOURCES += datafunctions.cpp \
+                   generatorcore.cpp
     }
 } else {
-    SOURCES += generatorcore.cpp
+    SOURCES += datafunctions.cpp \
+               generatorcore.cpp
+}
+
+no-avx2|!sse2|win32|*-icc*: CONFIG -= avx2
+
+avx2 {
+    DEFINES += HAVE_AVX2
+    AVX2_SOURCES += datafunctionsavx2.cpp
+    avx2_compiler.commands = $$QMAKE_CXX -c -mavx2 $(CXXFLAGS) $(INCPATH) ${QMAKE_FILE_IN} -o ${QMAKE_FILE_OUT}
+    avx2_compiler.dependency_type = TYPE_C
+    avx2_compiler.output = ${QMAKE_VAR_OBJECTS_DIR}${QMAKE_FILE_BASE}$${first(QMAKE_EXT_OBJ)}
+    avx2_compiler.input = AVX2_SOURCES
+    avx2_compiler.variable_out = OBJECTS
+    avx2_compiler.name = compiling[avx2] ${QMAKE_FILE_IN}
+    silent:avx2_compiler.commands = @echo compiling[avx2] ${QMAKE_FILE_IN} && $$avx2_compiler.commands
+    QMAKE_EXTRA_COMPILERS += avx2_compiler
 }
 
 include( xmlui/xmlui.pri )
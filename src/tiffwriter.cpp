@@ -0,0 +1,284 @@
+/**************************************************************************
+* This file is part of the Fraqtive program
+* Copyright (C) 2004-2012 Michał Męciński
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**************************************************************************/
+
+#include "tiffwriter.h"
+
+#include <QDataStream>
+
+enum FieldType
+{
+    ShortType = 3,
+    LongType = 4,
+    Long8Type = 16
+};
+
+enum FieldTag
+{
+    ImageWidthTag = 256,
+    ImageLengthTag = 257,
+    BitsPerSampleTag = 258,
+    CompressionTag = 259,
+    PhotometricTag = 262,
+    StripOffsetsTag = 273,
+    SamplesPerPixelTag = 277,
+    RowsPerStripTag = 278,
+    StripByteCountsTag = 279,
+    PlanarConfigurationTag = 284
+};
+
+static const int FieldCount = 10;
+
+// classic TIFF files use 32-bit offsets
+static const quint64 ClassicLimit = Q_UINT64_C( 0xffffffff );
+
+TiffWriter::TiffWriter( const QString& fileName ) :
+    m_file( fileName ),
+    m_rowsPerStrip( 0 ),
+    m_bigTiff( false ),
+    m_error( false ),
+    m_resumable( false )
+{
+}
+
+TiffWriter::~TiffWriter()
+{
+    // remove the incomplete file if writing was interrupted, unless it can be resumed
+    if ( m_file.isOpen() ) {
+        m_file.close();
+        if ( !m_resumable )
+            m_file.remove();
+    }
+}
+
+bool TiffWriter::open( const QSize& size, int rowsPerStrip )
+{
+    m_size = size;
+    m_rowsPerStrip = rowsPerStrip;
+
+    m_stripOffsets.clear();
+    m_stripByteCounts.clear();
+
+    m_resumable = false;
+
+    if ( !m_file.open( QIODevice::WriteOnly | QIODevice::Truncate ) ) {
+        m_error = true;
+        return false;
+    }
+
+    int strips = ( size.height() + rowsPerStrip - 1 ) / rowsPerStrip;
+
+    // BigTIFF is only used when the file doesn't fit in a classic TIFF
+    quint64 estimated = (quint64)size.width() * (quint64)size.height() * 3 + (quint64)strips * 8 + 1024;
+    m_bigTiff = estimated > ClassicLimit;
+
+    QDataStream stream( &m_file );
+    stream.setByteOrder( QDataStream::LittleEndian );
+
+    // the offset of the directory is written when the file is closed
+    stream.writeRawData( "II", 2 );
+    if ( m_bigTiff )
+        stream << (quint16)43 << (quint16)8 << (quint16)0 << (quint64)0;
+    else
+        stream << (quint16)42 << (quint32)0;
+
+    m_error = stream.status() != QDataStream::Ok;
+
+    return !m_error;
+}
+
+bool TiffWriter::resume( const QSize& size, int rowsPerStrip, const QByteArray& state )
+{
+    m_size = size;
+    m_rowsPerStrip = rowsPerStrip;
+
+    QDataStream input( state );
+
+    quint64 end;
+    input >> m_bigTiff >> m_stripOffsets >> m_stripByteCounts >> end;
+
+    if ( input.status() != QDataStream::Ok )
+        return false;
+
+    if ( !m_file.open( QIODevice::ReadWrite ) )
+        return false;
+
+    // strips written after the state was saved are discarded
+    if ( (quint64)m_file.size() < end || !m_file.resize( end ) || !m_file.seek( end ) ) {
+        m_file.close();
+        return false;
+    }
+
+    m_resumable = true;
+    m_error = false;
+
+    return true;
+}
+
+QByteArray TiffWriter::saveState()
+{
+    if ( m_error || !m_file.isOpen() || !m_file.flush() )
+        return QByteArray();
+
+    // the file is kept when writing is interrupted from now on
+    m_resumable = true;
+
+    QByteArray state;
+    QDataStream output( &state, QIODevice::WriteOnly );
+    output << m_bigTiff << m_stripOffsets << m_stripByteCounts << (quint64)m_file.pos();
+
+    return state;
+}
+
+bool TiffWriter::writeStrip( const QImage& image )
+{
+    if ( m_error || !m_file.isOpen() )
+        return false;
+
+    int width = m_size.width();
+
+    QByteArray row( 3 * width, 0 );
+
+    quint64 offset = m_file.pos();
+
+    for ( int y = 0; y < image.height(); y++ ) {
+        const QRgb* pixels = reinterpret_cast<const QRgb*>( image.scanLine( y ) );
+        char* data = row.data();
+
+        for ( int x = 0; x < width; x++ ) {
+            *data++ = (char)qRed( pixels[ x ] );
+            *data++ = (char)qGreen( pixels[ x ] );
+            *data++ = (char)qBlue( pixels[ x ] );
+        }
+
+        if ( m_file.write( row ) != row.size() ) {
+            m_error = true;
+            return false;
+        }
+    }
+
+    m_stripOffsets.append( offset );
+    m_stripByteCounts.append( (quint64)row.size() * image.height() );
+
+    return true;
+}
+
+bool TiffWriter::close()
+{
+    if ( m_error || !m_file.isOpen() )
+        return false;
+
+    QDataStream stream( &m_file );
+    stream.setByteOrder( QDataStream::LittleEndian );
+
+    // the directory must start on a word boundary
+    while ( m_file.pos() % 8 != 0 )
+        stream << (quint8)0;
+
+    quint64 directory = m_file.pos();
+
+    int strips = m_stripOffsets.count();
+
+    int entrySize = m_bigTiff ? 20 : 12;
+    int directorySize = m_bigTiff ? 8 + FieldCount * entrySize + 8 : 2 + FieldCount * entrySize + 4;
+
+    int offsetSize = m_bigTiff ? 8 : 4;
+    int offsetType = m_bigTiff ? Long8Type : LongType;
+
+    // values which don't fit in the entries are stored after the directory
+    quint64 extra = directory + directorySize;
+
+    quint64 bitsPerSample = Q_UINT64_C( 0x0000000800080008 );
+    quint64 bitsOffset = 0;
+    if ( !m_bigTiff ) {
+        bitsOffset = extra;
+        extra += 8;
+    }
+
+    bool inlineStrips = strips == 1;
+
+    quint64 offsetsOffset = extra;
+    quint64 countsOffset = extra + strips * offsetSize;
+
+    if ( m_bigTiff )
+        stream << (quint64)FieldCount;
+    else
+        stream << (quint16)FieldCount;
+
+    writeEntry( stream, ImageWidthTag, LongType, 1, m_size.width() );
+    writeEntry( stream, ImageLengthTag, LongType, 1, m_size.height() );
+    writeEntry( stream, BitsPerSampleTag, ShortType, 3, m_bigTiff ? bitsPerSample : bitsOffset );
+    writeEntry( stream, CompressionTag, ShortType, 1, 1 );
+    writeEntry( stream, PhotometricTag, ShortType, 1, 2 );
+    writeEntry( stream, StripOffsetsTag, offsetType, strips, inlineStrips ? m_stripOffsets.first() : offsetsOffset );
+    writeEntry( stream, SamplesPerPixelTag, ShortType, 1, 3 );
+    writeEntry( stream, RowsPerStripTag, LongType, 1, m_rowsPerStrip );
+    writeEntry( stream, StripByteCountsTag, offsetType, strips, inlineStrips ? m_stripByteCounts.first() : countsOffset );
+    writeEntry( stream, PlanarConfigurationTag, ShortType, 1, 1 );
+
+    // there is no next directory
+    if ( m_bigTiff )
+        stream << (quint64)0;
+    else
+        stream << (quint32)0;
+
+    if ( !m_bigTiff )
+        stream << (quint16)8 << (quint16)8 << (quint16)8 << (quint16)0;
+
+    if ( !inlineStrips ) {
+        for ( int i = 0; i < strips; i++ ) {
+            if ( m_bigTiff )
+                stream << (quint64)m_stripOffsets.at( i );
+            else
+                stream << (quint32)m_stripOffsets.at( i );
+        }
+        for ( int i = 0; i < strips; i++ ) {
+            if ( m_bigTiff )
+                stream << (quint64)m_stripByteCounts.at( i );
+            else
+                stream << (quint32)m_stripByteCounts.at( i );
+        }
+    }
+
+    // update the offset of the directory in the header
+    m_file.seek( m_bigTiff ? 8 : 4 );
+    if ( m_bigTiff )
+        stream << (quint64)directory;
+    else
+        stream << (quint32)directory;
+
+    if ( stream.status() != QDataStream::Ok || m_file.error() != QFile::NoError )
+        m_error = true;
+
+    m_file.close();
+
+    if ( m_error )
+        m_file.remove();
+
+    return !m_error;
+}
+
+void TiffWriter::writeEntry( QDataStream& stream, int tag, int type, quint64 count, quint64 value )
+{
+    stream << (quint16)tag << (quint16)type;
+
+    // values which fit in the entry are stored directly, starting at the first byte
+    if ( m_bigTiff )
+        stream << (quint64)count << (quint64)value;
+    else
+        stream << (quint32)count << (quint32)value;
+}
@@ -0,0 +1,63 @@
+/**************************************************************************
+* This file is part of the Fraqtive program
+* Copyright (C) 2004-2012 Michał Męciński
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**************************************************************************/
+
+#ifndef TIFFWRITER_H
+#define TIFFWRITER_H
+
+#include <QFile>
+#include <QImage>
+#include <QVector>
+
+class QDataStream;
+
+class TiffWriter
+{
+public:
+    TiffWriter( const QString& fileName );
+    ~TiffWriter();
+
+public:
+    bool open( const QSize& size, int rowsPerStrip );
+    bool resume( const QSize& size, int rowsPerStrip, const QByteArray& state );
+
+    bool writeStrip( const QImage& image );
+
+    QByteArray saveState();
+
+    bool close();
+
+    bool hasError() const { return m_error; }
+
+private:
+    void writeEntry( QDataStream& stream, int tag, int type, quint64 count, quint64 value );
+
+private:
+    QFile m_file;
+
+    QSize m_size;
+    int m_rowsPerStrip;
+
+    bool m_bigTiff;
+    bool m_error;
+    bool m_resumable;
+
+    QVector<quint64> m_stripOffsets;
+    QVector<quint64> m_stripByteCounts;
+};
+
+#endif
@@ -0,0 +1,150 @@
+/**************************************************************************
+* This file is part of the Fraqtive program
+* Copyright (C) 2004-2012 Michał Męciński
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**************************************************************************/
+
+#include "tileprotocol.h"
+
+#include <QDataStream>
+#include <QIODevice>
+
+namespace TileProtocol
+{
+
+// the settings are written field by field because the stream operators of some
+// structures depend on the version of the configuration files read by the process
+
+static void writeColorMapping( QDataStream& stream, const ColorMapping& mapping )
+{
+    stream << mapping.isMirrored() << mapping.isReversed() << mapping.scale() << mapping.offset() << (qint8)mapping.transform();
+}
+
+static void readColorMapping( QDataStream& stream, ColorMapping& mapping )
+{
+    bool mirrored;
+    bool reversed;
+    double scale;
+    double offset;
+    qint8 transform;
+    stream >> mirrored >> reversed >> scale >> offset >> transform;
+
+    mapping.setMirrored( mirrored );
+    mapping.setReversed( reversed );
+    mapping.setScale( scale );
+    mapping.setOffset( offset );
+    mapping.setTransform( (ValueTransform)transform );
+}
+
+static void writeGeneratorSettings( QDataStream& stream, const GeneratorSettings& settings )
+{
+    stream << settings.calculationDepth() << settings.detailThreshold() << settings.automaticDepth();
+}
+
+static void readGeneratorSettings( QDataStream& stream, GeneratorSettings& settings )
+{
+    double depth;
+    double threshold;
+    bool automatic;
+    stream >> depth >> threshold >> automatic;
+
+    settings.setCalculationDepth( depth );
+    settings.setDetailThreshold( threshold );
+    settings.setAutomaticDepth( automatic );
+}
+
+static void writeViewSettings( QDataStream& stream, const ViewSettings& settings )
+{
+    stream << (qint8)settings.antiAliasing() << (qint8)settings.meshResolution() << settings.heightScale() << settings.cameraZoom();
+}
+
+static void readViewSettings( QDataStream& stream, ViewSettings& settings )
+{
+    qint8 antiAliasing;
+    qint8 resolution;
+    double heightScale;
+    double cameraZoom;
+    stream >> antiAliasing >> resolution >> heightScale >> cameraZoom;
+
+    settings.setAntiAliasing( (AntiAliasing)antiAliasing );
+    settings.setMeshResolution( (Resolution)resolution );
+    settings.setHeightScale( heightScale );
+    settings.setCameraZoom( cameraZoom );
+}
+
+QDataStream& operator <<( QDataStream& stream, const RenderSettings& settings )
+{
+    stream << settings.m_type << settings.m_position
+        << settings.m_resolution << (qint32)settings.m_multiSampling << settings.m_adaptive
+        << settings.m_gradient << settings.m_backgroundColor;
+
+    writeColorMapping( stream, settings.m_colorMapping );
+    writeGeneratorSettings( stream, settings.m_generatorSettings );
+    writeViewSettings( stream, settings.m_viewSettings );
+
+    return stream;
+}
+
+QDataStream& operator >>( QDataStream& stream, RenderSettings& settings )
+{
+    qint32 multiSampling;
+    stream >> settings.m_type >> settings.m_position
+        >> settings.m_resolution >> multiSampling >> settings.m_adaptive
+        >> settings.m_gradient >> settings.m_backgroundColor;
+    settings.m_multiSampling = multiSampling;
+
+    readColorMapping( stream, settings.m_colorMapping );
+    readGeneratorSettings( stream, settings.m_generatorSettings );
+    readViewSettings( stream, settings.m_viewSettings );
+
+    return stream;
+}
+
+void sendMessage( QIODevice* device, const QByteArray& message )
+{
+    QByteArray header;
+    QDataStream stream( &header, QIODevice::WriteOnly );
+    stream << (quint32)message.size();
+
+    device->write( header );
+    device->write( message );
+}
+
+ReceiveStatus receiveMessage( QIODevice* device, QByteArray* message )
+{
+    if ( device->bytesAvailable() < (qint64)sizeof( quint32 ) )
+        return MessagePending;
+
+    QByteArray header = device->peek( sizeof( quint32 ) );
+    QDataStream stream( header );
+
+    quint32 size;
+    stream >> size;
+
+    // don't wait for a message which could never be allocated
+    if ( size > MaximumMessageSize )
+        return MessageInvalid;
+
+    // wait until the whole message is received
+    if ( device->bytesAvailable() < (qint64)( sizeof( quint32 ) + size ) )
+        return MessagePending;
+
+    device->read( sizeof( quint32 ) );
+    *message = device->read( size );
+
+    return MessageReceived;
+}
+
+} // namespace TileProtocol
@@ -0,0 +1,80 @@
+/**************************************************************************
+* This file is part of the Fraqtive program
+* Copyright (C) 2004-2012 Michał Męciński
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**************************************************************************/
+
+#ifndef TILEPROTOCOL_H
+#define TILEPROTOCOL_H
+
+#include <QColor>
+#include <QByteArray>
+
+#include "datastructures.h"
+
+class QIODevice;
+
+// messages exchanged between the render coordinator and its worker processes
+namespace TileProtocol
+{
+
+// the largest tile sent by a worker; a single scan line must fit in a tile
+static const int MaximumTilePixels = 4 * 1024 * 1024;
+
+// the pixels of the largest tile with room for the header and the render settings
+static const quint32 MaximumMessageSize = MaximumTilePixels * sizeof( QRgb ) + 64 * 1024;
+
+enum MessageType
+{
+    RenderTileMessage = 1,
+    TileRenderedMessage,
+    TileFailedMessage
+};
+
+struct RenderSettings
+{
+    FractalType m_type;
+    Position m_position;
+
+    QSize m_resolution;
+    int m_multiSampling;
+    bool m_adaptive;
+
+    Gradient m_gradient;
+    QColor m_backgroundColor;
+    ColorMapping m_colorMapping;
+
+    GeneratorSettings m_generatorSettings;
+    ViewSettings m_viewSettings;
+};
+
+QDataStream& operator <<( QDataStream& stream, const RenderSettings& settings );
+QDataStream& operator >>( QDataStream& stream, RenderSettings& settings );
+
+enum ReceiveStatus
+{
+    MessagePending,
+    MessageReceived,
+    MessageInvalid
+};
+
+// each message is preceded by its size; a larger size than the maximum
+// means that the stream is corrupted and the connection should be closed
+void sendMessage( QIODevice* device, const QByteArray& message );
+ReceiveStatus receiveMessage( QIODevice* device, QByteArray* message );
+
+} // namespace TileProtocol
+
+#endif
@@ -0,0 +1,263 @@
+/**************************************************************************
+* This file is part of the Fraqtive program
+* Copyright (C) 2004-2012 Michał Męciński
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**************************************************************************/
+
+#include "videowriter.h"
+
+#include <QFile>
+#include <QProcess>
+#include <QDir>
+#include <QStringList>
+
+static const int FrameRate = 25;
+
+static const char FrameHeader[] = "FRAME\n";
+static const int FrameHeaderSize = sizeof( FrameHeader ) - 1;
+
+// split the command into arguments separated by spaces; arguments
+// which contain spaces can be enclosed in double quotes
+static QStringList splitCommand( const QString& command )
+{
+    QStringList arguments;
+    QString argument;
+    bool quoted = false;
+    bool empty = true;
+
+    for ( int i = 0; i < command.length(); i++ ) {
+        QChar ch = command.at( i );
+        if ( ch == QLatin1Char( '"' ) ) {
+            quoted = !quoted;
+            empty = false;
+        } else if ( ch.isSpace() && !quoted ) {
+            if ( !empty ) {
+                arguments.append( argument );
+                argument.clear();
+                empty = true;
+            }
+        } else {
+            argument += ch;
+            empty = false;
+        }
+    }
+
+    if ( !empty )
+        arguments.append( argument );
+
+    return arguments;
+}
+
+VideoWriter::VideoWriter( const QString& fileName, const QByteArray& format, const QString& encoder ) :
+    m_fileName( fileName ),
+    m_format( format ),
+    m_encoder( encoder ),
+    m_device( NULL ),
+    m_error( false )
+{
+}
+
+VideoWriter::~VideoWriter()
+{
+    // stop the encoder or remove the incomplete file if writing was interrupted
+    if ( QProcess* process = qobject_cast<QProcess*>( m_device ) ) {
+        process->kill();
+        process->waitForFinished( -1 );
+    } else if ( QFile* file = qobject_cast<QFile*>( m_device ) ) {
+        file->close();
+        file->remove();
+    }
+
+    delete m_device;
+}
+
+bool VideoWriter::isVideoFormat( const QByteArray& format )
+{
+    return format == "y4m" || format == "raw";
+}
+
+bool VideoWriter::open( const QSize& size )
+{
+    m_size = size;
+
+    if ( m_encoder.isEmpty() ) {
+        QFile* file = new QFile( m_fileName );
+        m_device = file;
+
+        if ( !file->open( QIODevice::WriteOnly | QIODevice::Truncate ) ) {
+            m_error = true;
+            return false;
+        }
+    } else {
+        QProcess* process = new QProcess();
+        m_device = process;
+
+        // the encoder's messages would block it if they were not read
+        process->setProcessChannelMode( QProcess::ForwardedChannels );
+
+        // the file name is passed as a separate argument, so it doesn't need quoting
+        QStringList arguments = splitCommand( m_encoder );
+        if ( arguments.isEmpty() ) {
+            m_error = true;
+            return false;
+        }
+
+        for ( int i = 0; i < arguments.count(); i++ )
+            arguments[ i ].replace( QLatin1String( "%1" ), QDir::toNativeSeparators( m_fileName ) );
+
+        QString program = arguments.takeFirst();
+
+        process->start( program, arguments, QIODevice::WriteOnly );
+
+        if ( !process->waitForStarted( -1 ) ) {
+            m_error = true;
+            return false;
+        }
+    }
+
+    if ( m_format == "y4m" ) {
+        int chromaSize = ( ( size.width() + 1 ) / 2 ) * ( ( size.height() + 1 ) / 2 );
+
+        m_buffer.resize( FrameHeaderSize + size.width() * size.height() + 2 * chromaSize );
+        memcpy( m_buffer.data(), FrameHeader, FrameHeaderSize );
+
+        // the frames are converted using the full range of values
+        QByteArray header = QString( "YUV4MPEG2 W%1 H%2 F%3:1 Ip A1:1 C420jpeg XCOLORRANGE=FULL\n" ).arg( size.width() ).arg( size.height() ).arg( FrameRate ).toLatin1();
+
+        if ( !write( header.constData(), header.size() ) )
+            return false;
+    }
+
+    return true;
+}
+
+bool VideoWriter::writeFrame( const QImage& image )
+{
+    if ( m_error || m_device == NULL )
+        return false;
+
+    if ( m_format == "y4m" ) {
+        convertFrame( image );
+        return write( m_buffer.constData(), m_buffer.size() );
+    }
+
+    // raw frames are written directly from the image in its native 0xffRRGGBB layout
+    if ( image.format() != QImage::Format_RGB32 ) {
+        QImage converted = image.convertToFormat( QImage::Format_RGB32 );
+        return write( reinterpret_cast<const char*>( converted.bits() ), converted.byteCount() );
+    }
+
+    return write( reinterpret_cast<const char*>( image.bits() ), image.byteCount() );
+}
+
+bool VideoWriter::close()
+{
+    if ( m_error || m_device == NULL )
+        return false;
+
+    if ( QProcess* process = qobject_cast<QProcess*>( m_device ) ) {
+        process->closeWriteChannel();
+
+        if ( !process->waitForFinished( -1 ) || process->exitStatus() != QProcess::NormalExit || process->exitCode() != 0 )
+            m_error = true;
+    } else {
+        QFile* file = qobject_cast<QFile*>( m_device );
+
+        if ( !file->flush() )
+            m_error = true;
+
+        file->close();
+
+        if ( m_error )
+            file->remove();
+    }
+
+    delete m_device;
+    m_device = NULL;
+
+    return !m_error;
+}
+
+bool VideoWriter::write( const char* data, qint64 size )
+{
+    if ( m_device->write( data, size ) != size ) {
+        m_error = true;
+        return false;
+    }
+
+    // wait until the encoder reads the frame so that frames are not buffered in memory
+    if ( QProcess* process = qobject_cast<QProcess*>( m_device ) ) {
+        while ( process->bytesToWrite() > 0 ) {
+            if ( !process->waitForBytesWritten( -1 ) ) {
+                m_error = true;
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+static inline uchar lumaValue( QRgb color )
+{
+    return (uchar)( ( 19595 * qRed( color ) + 38470 * qGreen( color ) + 7471 * qBlue( color ) + 32768 ) >> 16 );
+}
+
+static inline uchar chromaValue( int cr, int cg, int cb, int red, int green, int blue )
+{
+    return (uchar)qMin( ( cr * red + cg * green + cb * blue + ( 128 << 16 ) + 32768 ) >> 16, 255 );
+}
+
+void VideoWriter::convertFrame( const QImage& image )
+{
+    int width = m_size.width();
+    int height = m_size.height();
+
+    uchar* luma = reinterpret_cast<uchar*>( m_buffer.data() ) + FrameHeaderSize;
+    uchar* blueChroma = luma + width * height;
+    uchar* redChroma = blueChroma + ( ( width + 1 ) / 2 ) * ( ( height + 1 ) / 2 );
+
+    // full range BT.601 with chroma of each 2x2 block, converted in a single pass into the frame buffer
+    for ( int y = 0; y < height; y += 2 ) {
+        int y2 = qMin( y + 1, height - 1 );
+
+        const QRgb* line1 = reinterpret_cast<const QRgb*>( image.scanLine( y ) );
+        const QRgb* line2 = reinterpret_cast<const QRgb*>( image.scanLine( y2 ) );
+
+        uchar* luma1 = luma + y * width;
+        uchar* luma2 = luma + y2 * width;
+
+        for ( int x = 0; x < width; x += 2 ) {
+            int x2 = qMin( x + 1, width - 1 );
+
+            QRgb c11 = line1[ x ];
+            QRgb c12 = line1[ x2 ];
+            QRgb c21 = line2[ x ];
+            QRgb c22 = line2[ x2 ];
+
+            luma1[ x ] = lumaValue( c11 );
+            luma1[ x2 ] = lumaValue( c12 );
+            luma2[ x ] = lumaValue( c21 );
+            luma2[ x2 ] = lumaValue( c22 );
+
+            int red = ( qRed( c11 ) + qRed( c12 ) + qRed( c21 ) + qRed( c22 ) + 2 ) >> 2;
+            int green = ( qGreen( c11 ) + qGreen( c12 ) + qGreen( c21 ) + qGreen( c22 ) + 2 ) >> 2;
+            int blue = ( qBlue( c11 ) + qBlue( c12 ) + qBlue( c21 ) + qBlue( c22 ) + 2 ) >> 2;
+
+            *blueChroma++ = chromaValue( -11059, -21709, 32768, red, green, blue );
+            *redChroma++ = chromaValue( 32768, -27439, -5329, red, green, blue );
+        }
+    }
+}
@@ -0,0 +1,64 @@
+/**************************************************************************
+* This file is part of the Fraqtive program
+* Copyright (C) 2004-2012 Michał Męciński
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**************************************************************************/
+
+#ifndef VIDEOWRITER_H
+#define VIDEOWRITER_H
+
+#include <QImage>
+#include <QByteArray>
+
+class QIODevice;
+
+// writes uncompressed video frames to a file or to the standard input of an encoder
+class VideoWriter
+{
+public:
+    VideoWriter( const QString& fileName, const QByteArray& format, const QString& encoder );
+    ~VideoWriter();
+
+public:
+    static bool isVideoFormat( const QByteArray& format );
+
+    bool open( const QSize& size );
+
+    bool writeFrame( const QImage& image );
+
+    bool close();
+
+    bool hasError() const { return m_error; }
+
+private:
+    bool write( const char* data, qint64 size );
+
+    void convertFrame( const QImage& image );
+
+private:
+    QString m_fileName;
+    QByteArray m_format;
+    QString m_encoder;
+
+    QIODevice* m_device;
+
+    QSize m_size;
+
+    QByteArray m_buffer;
+
+    bool m_error;
+};
+
+#endif